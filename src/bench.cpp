@@ -0,0 +1,807 @@
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <atomic>
+#include <map>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+
+#include "bench.h"
+#include "config.h"
+#include "shim.h"
+
+using namespace project;
+using namespace std;
+
+namespace project {
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(const bench_clock::time_point &start) {
+  return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+static void report(const string &name, int iterations, double total_ms) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  cout << "bench " << name << ": " << iterations << " iterations, "
+       << fixed << setprecision(3) << total_ms << " ms total, "
+       << total_ms / iterations << " ms/iteration, "
+       << "max rss " << ru.ru_maxrss << " KB" << endl;
+}
+
+// time shim_cfg::parse_config only, the libconfig file read is excluded
+static bool bench_parse(const string &name, const string &cfg, int iterations,
+                        unsigned n_threads) {
+  double total = 0;
+  for (int i = 0; i < iterations; ++i) {
+    shim_cfg c;
+    c.set_parallel(n_threads);
+    if (!c.load_config(cfg)) {
+      cerr << "failed to load " << cfg << ", " << c.get_error() << endl;
+      return false;
+    }
+    auto start = bench_clock::now();
+    if (!c.parse_config()) {
+      cerr << "failed to parse " << cfg << ", " << c.get_error() << endl;
+      return false;
+    }
+    total += elapsed_ms(start);
+  }
+  report(name, iterations, total);
+  return true;
+}
+
+// time libconfig read plus parse_config, to compare with streaming load
+static bool bench_load(const string &cfg, int iterations) {
+  double total = 0;
+  for (int i = 0; i < iterations; ++i) {
+    shim_cfg c;
+    auto start = bench_clock::now();
+    if (!c.load_config(cfg) || !c.parse_config()) {
+      cerr << "failed to load " << cfg << ", " << c.get_error() << endl;
+      return false;
+    }
+    total += elapsed_ms(start);
+  }
+  report("load", iterations, total);
+  return true;
+}
+
+// time shim_cfg::stream_config, read and parse in one pass
+static bool bench_stream(const string &cfg, int iterations) {
+  double total = 0;
+  for (int i = 0; i < iterations; ++i) {
+    shim_cfg c;
+    auto start = bench_clock::now();
+    if (!c.stream_config(cfg)) {
+      cerr << "failed to stream " << cfg << ", " << c.get_error() << endl;
+      return false;
+    }
+    total += elapsed_ms(start);
+  }
+  report("stream", iterations, total);
+  return true;
+}
+
+// time shim_cfg::map_config plus parse_config, to compare with libconfig load,
+// with n threads the included files are tokenized and sites decoded in parallel
+static bool bench_mmap(const string &name, const string &cfg, int iterations,
+                       unsigned n_threads) {
+  double total = 0;
+  for (int i = 0; i < iterations; ++i) {
+    shim_cfg c;
+    c.set_parallel(n_threads);
+    auto start = bench_clock::now();
+    if (!c.map_config(cfg) || !c.parse_config()) {
+      cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+      return false;
+    }
+    total += elapsed_ms(start);
+  }
+  report(name, iterations, total);
+  return true;
+}
+
+// time shim_cfg::cache_config from a valid snapshot, the first untimed
+// iteration writes the snapshot
+static bool bench_cache(const string &cfg, int iterations) {
+  double total = 0;
+  for (int i = 0; i <= iterations; ++i) {
+    shim_cfg c;
+    auto start = bench_clock::now();
+    if (!c.cache_config(cfg)) {
+      cerr << "failed to load " << cfg << ", " << c.get_error() << endl;
+      return false;
+    }
+    if (i > 0)
+      total += elapsed_ms(start);
+  }
+  report("cache", iterations, total);
+  return true;
+}
+
+// time shim_cfg::reload_config of the unchanged file after one full load
+static bool bench_reload(const string &cfg, int iterations) {
+  double total = 0;
+  shim_cfg c;
+  if (!c.map_config(cfg) || !c.parse_config()) {
+    cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+    return false;
+  }
+  for (int i = 0; i < iterations; ++i) {
+    auto start = bench_clock::now();
+    if (!c.reload_config(cfg)) {
+      cerr << "failed to reload " << cfg << ", " << c.get_error() << endl;
+      return false;
+    }
+    total += elapsed_ms(start);
+  }
+  report("reload", iterations, total);
+  return true;
+}
+
+// time shim_cfg::map_config plus parse_config with aps decoded on demand, and
+// one read of two members of every ap, as a service using few members would
+static bool bench_lazy(const string &cfg, int iterations) {
+  double total = 0;
+  for (int i = 0; i < iterations; ++i) {
+    shim_cfg c;
+    c.set_lazy(true);
+    auto start = bench_clock::now();
+    if (!c.map_config(cfg) || !c.parse_config()) {
+      cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+      return false;
+    }
+    unsigned n_on = 0;
+    shim::instance().for_each_ap([&n_on](const object_config_ptr &oc) {
+      ap_config *cc = dynamic_cast<ap_config *>(oc.get());
+      if (cc && cc->get_admin_state() && cc->get_central_freq_khz() > 0)
+        ++n_on;
+    });
+    total += elapsed_ms(start);
+    (void)n_on;
+  }
+  report("lazy", iterations, total);
+  return true;
+}
+
+// latency of lookup by key and by map id in random order, store_index of
+// shim against the two ordered maps it replaced, key -> object and id -> key.
+// The cfg file is not used, keys and ids are generated as for aps
+static bool bench_lookup(int iterations) {
+  double total = 0;
+  for (size_t n : { 10000, 100000, 1000000 }) {
+    vector<string> keys(n);
+    vector<uint64_t> ids(n);
+    map<string, object_config_ptr> key_obj;
+    map<uint64_t, string> id_key;
+    store_index<object_config_ptr> index;
+    for (size_t i = 0; i < n; ++i) {
+      char key[32];
+      snprintf(key, sizeof(key), "FCC%zu:SN%08zu", i % 7, i);
+      keys[i] = key;
+      ids[i] = ((uint64_t)enum_id_ap << id_allocator::enum_shift_type) | i;
+      key_obj[keys[i]] = nullptr;
+      id_key[ids[i]] = keys[i];
+      index.insert(keys[i], ids[i], nullptr);
+    }
+    vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i)
+      order[i] = i;
+    shuffle(order.begin(), order.end(), mt19937(1));
+
+    double t[4] = { 0, 0, 0, 0 };
+    size_t found = 0;
+    for (int it = 0; it < iterations; ++it) {
+      auto start = bench_clock::now();
+      for (size_t i : order)
+        found += (key_obj.find(keys[i]) != key_obj.end());
+      t[0] += elapsed_ms(start);
+      start = bench_clock::now();
+      for (size_t i : order) {
+        auto k = id_key.find(ids[i]);
+        found += (k != id_key.end() && key_obj.find(k->second) != key_obj.end());
+      }
+      t[1] += elapsed_ms(start);
+      start = bench_clock::now();
+      for (size_t i : order)
+        found += (index.find(keys[i]) >= 0);
+      t[2] += elapsed_ms(start);
+      start = bench_clock::now();
+      for (size_t i : order)
+        found += (index.find(ids[i]) >= 0);
+      t[3] += elapsed_ms(start);
+    }
+    if (found != 4 * n * iterations) {
+      cerr << "lookup missed " << 4 * n * iterations - found << " objects" << endl;
+      return false;
+    }
+    total += t[0] + t[1] + t[2] + t[3];
+    double per = 1e6 / ((double)n * iterations);
+    cout << "bench lookup " << n << " objects: ns/lookup"
+         << fixed << setprecision(1)
+         << ", map key " << t[0] * per << ", map id " << t[1] * per
+         << ", index key " << t[2] * per << ", index id " << t[3] * per << endl;
+  }
+  report("lookup", iterations, total);
+  return true;
+}
+
+// time one walk over all loaded objects, copies of the store against views
+// and visitors in place
+static bool bench_walk(const string &cfg, int iterations) {
+  shim_cfg c;
+  if (!c.map_config(cfg) || !c.parse_config()) {
+    cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+    return false;
+  }
+  shim &sh = shim::instance();
+  double t[4] = { 0, 0, 0, 0 };
+  size_t n = 0;
+  for (int i = 0; i < iterations; ++i) {
+    auto start = bench_clock::now();
+    for (const auto &oc : sh.get_ordered_oc())
+      n += (oc->get_ver() >= 0);
+    t[0] += elapsed_ms(start);
+    start = bench_clock::now();
+    for (const auto &p : sh.get_key_obj())
+      n += (p.second->get_ver() >= 0);
+    t[1] += elapsed_ms(start);
+    start = bench_clock::now();
+    for (const auto &oc : sh.ordered_view())
+      n += (oc->get_ver() >= 0);
+    t[2] += elapsed_ms(start);
+    start = bench_clock::now();
+    sh.for_each_config([&n](const object_config_ptr &oc) { n += (oc->get_ver() >= 0); });
+    t[3] += elapsed_ms(start);
+  }
+  cout << "bench walk " << sh.size() << " objects: ms/walk" << fixed
+       << setprecision(3) << ", get_ordered_oc " << t[0] / iterations
+       << ", get_key_obj " << t[1] / iterations << ", ordered_view "
+       << t[2] / iterations << ", for_each_config " << t[3] / iterations
+       << endl;
+  report("walk", iterations, t[0] + t[1] + t[2] + t[3]);
+  return n > 0;
+}
+
+// reader throughput of the store while a writer reloads the unchanged file in
+// a loop, readers of published snapshots against readers of the live store
+// under a shared lock which the writer holds while reloading
+static bool bench_rcu(const string &cfg, int iterations) {
+  shim &sh = shim::instance();
+  sh.set_concurrent(true);
+  shim_cfg c;
+  if (!c.map_config(cfg) || !c.parse_config()) {
+    cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+    return false;
+  }
+  vector<string> keys;
+  {
+    shim::reader r;
+    r->for_each_config([&keys](const object_config_ptr &oc) { keys.push_back(oc->get_key()); });
+  }
+  unsigned n_readers = max(2u, thread::hardware_concurrency());
+  auto duration = chrono::milliseconds(500 * iterations);
+
+  enum { enum_rcu_idle, enum_rcu_write, enum_lock_write, enum_n_phases };
+  static const char *s_phases[] = { "rcu, no writer", "rcu, writer", "shared lock, writer" };
+  shared_mutex lock;
+  double total = 0;
+  for (int phase = 0; phase < enum_n_phases; ++phase) {
+    atomic<bool> stop(false);
+    atomic<size_t> n_reads(0), n_misses(0);
+    vector<thread> readers;
+    for (unsigned i = 0; i < n_readers; ++i)
+      readers.emplace_back([&, i] {
+        size_t n = 0, misses = 0, k = i * 7919;
+        while (!stop.load(memory_order_relaxed)) {
+          k = (k * 1103515245 + 12345) % keys.size();
+          if (phase == enum_lock_write) {
+            shared_lock<shared_mutex> l(lock);
+            misses += (sh.find_config(keys[k]) == nullptr);
+          }
+          else {
+            shim::reader r;
+            misses += (r->find_config(keys[k]) == nullptr);
+          }
+          ++n;
+        }
+        n_reads += n;
+        n_misses += misses;
+      });
+
+    size_t n_writes = 0;
+    double write_ms = 0;
+    auto start = bench_clock::now();
+    while (bench_clock::now() - start < duration) {
+      if (phase == enum_rcu_idle) {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        continue;
+      }
+      auto w = bench_clock::now();
+      if (phase == enum_lock_write) {
+        unique_lock<shared_mutex> l(lock);
+        c.reload_config(cfg);
+      }
+      else
+        c.reload_config(cfg);
+      write_ms += elapsed_ms(w);
+      ++n_writes;
+    }
+    stop = true;
+    for (auto &r : readers)
+      r.join();
+    double ms = elapsed_ms(start);
+    total += ms;
+    cout << "bench rcu " << s_phases[phase] << ": " << n_readers << " readers, "
+         << fixed << setprecision(1) << n_reads / ms / 1000 << " M reads/s, "
+         << n_writes << " writes, " << (n_writes ? write_ms / n_writes : 0)
+         << " ms/write, " << n_misses << " misses, " << sh.get_n_retired()
+         << " snapshots retired" << endl;
+    if (n_misses > 0)
+      return false;
+  }
+  sh.set_concurrent(false);
+  report("rcu", iterations, total);
+  return true;
+}
+
+// latency of queries on ap fields, a scan of find_all_config against
+// shim::query over secondary indexes. Each sampled ap is looked up by serial
+// number and by vendor, firmware and site
+static bool bench_query(const string &cfg, int iterations) {
+  shim_cfg c;
+  if (!c.map_config(cfg) || !c.parse_config()) {
+    cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+    return false;
+  }
+  shim &sh = shim::instance();
+  vector<ap_config_ptr> sample;
+  sh.for_each_ap([&sample](const object_config_ptr &oc) {
+    ap_config_ptr ap = dynamic_pointer_cast<ap_config>(oc);
+    if (ap)
+      sample.push_back(ap);
+  });
+  if (sample.empty()) {
+    cerr << "no aps in " << cfg << endl;
+    return false;
+  }
+  shuffle(sample.begin(), sample.end(), mt19937(1));
+  sample.resize(min(sample.size(), (size_t)100));
+
+  auto start = bench_clock::now();
+  for (const char *f : { "serial_number", "vendor", "firmware_version", "site_name" })
+    sh.create_index(f);
+  double t_index = elapsed_ms(start);
+
+  double t[2] = { 0, 0 };
+  size_t n[2] = { 0, 0 };
+  for (int i = 0; i < iterations; ++i) {
+    start = bench_clock::now();
+    for (const auto &ap : sample) {
+      for (const auto &oc : sh.find_all_config()) {
+        ap_config_ptr a = dynamic_pointer_cast<ap_config>(oc);
+        if (!a)
+          continue;
+        n[0] += (a->get_serial_number() == ap->get_serial_number());
+        n[0] += (a->get_vendor() == ap->get_vendor()
+                 && a->get_firmware_version() == ap->get_firmware_version()
+                 && a->get_site_name() == ap->get_site_name());
+      }
+    }
+    t[0] += elapsed_ms(start);
+    start = bench_clock::now();
+    for (const auto &ap : sample) {
+      n[1] += sh.query({ { "serial_number", ap->get_serial_number() } }).size();
+      n[1] += sh.query({ { "vendor", ap->get_vendor() },
+                         { "firmware_version", ap->get_firmware_version() },
+                         { "site_name", ap->get_site_name() } }).size();
+    }
+    t[1] += elapsed_ms(start);
+  }
+  for (const char *f : { "serial_number", "vendor", "firmware_version", "site_name" })
+    sh.drop_index(f);
+  if (n[0] != n[1]) {
+    cerr << "query matched " << n[1] << " aps, scan " << n[0] << endl;
+    return false;
+  }
+  double per = 1e3 / (2.0 * sample.size() * iterations);
+  cout << "bench query " << sh.size() << " objects: us/query" << fixed
+       << setprecision(1) << ", scan " << t[0] * per << ", index "
+       << t[1] * per << ", index build " << setprecision(3) << t_index
+       << " ms" << endl;
+  report("query", iterations, t[0] + t[1]);
+  return true;
+}
+
+// latency of radius and box queries at 10k, 100k and 1M aps spread over one
+// degree square, grid_index against a scan of all points. The cfg file is not
+// used
+static bool bench_spatial(int iterations) {
+  double total = 0;
+  const size_t n_queries = 200;
+  const double meters = 500, box_deg = 0.01;
+  for (size_t n : { 10000, 100000, 1000000 }) {
+    mt19937 rng(1);
+    uniform_real_distribution<double> lat_of(41.0, 42.0), lon_of(-92.0, -91.0);
+    vector<pair<double, double>> points(n);
+    grid_index grid;
+    auto start = bench_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+      points[i] = make_pair(lat_of(rng), lon_of(rng));
+      grid.insert(i + 1, points[i].first, points[i].second);
+    }
+    double t_build = elapsed_ms(start);
+    vector<pair<double, double>> centers(n_queries);
+    for (auto &c : centers)
+      c = make_pair(lat_of(rng), lon_of(rng));
+
+    double t[4] = { 0, 0, 0, 0 };
+    size_t found[4] = { 0, 0, 0, 0 };
+    auto count = [&found](int k) {
+      return [&found, k](uint64_t, double, double) { ++found[k]; };
+    };
+    for (int it = 0; it < iterations; ++it) {
+      start = bench_clock::now();
+      for (const auto &c : centers)
+        for (const auto &p : points)
+          found[0] += (grid_index::distance_m(c.first, c.second, p.first, p.second) <= meters);
+      t[0] += elapsed_ms(start);
+      start = bench_clock::now();
+      for (const auto &c : centers)
+        grid.for_each_in_radius(c.first, c.second, meters, count(1));
+      t[1] += elapsed_ms(start);
+      start = bench_clock::now();
+      for (const auto &c : centers)
+        for (const auto &p : points)
+          found[2] += (p.first >= c.first && p.first <= c.first + box_deg
+                       && p.second >= c.second && p.second <= c.second + box_deg);
+      t[2] += elapsed_ms(start);
+      start = bench_clock::now();
+      for (const auto &c : centers)
+        grid.for_each_in_box(c.first, c.first + box_deg, c.second,
+                             c.second + box_deg, count(3));
+      t[3] += elapsed_ms(start);
+    }
+    if (found[0] != found[1] || found[2] != found[3]) {
+      cerr << "spatial found " << found[1] << " and " << found[3]
+           << " aps, scan " << found[0] << " and " << found[2] << endl;
+      return false;
+    }
+    total += t[0] + t[1] + t[2] + t[3];
+    double per = 1e3 / ((double)n_queries * iterations);
+    cout << "bench spatial " << n << " aps: us/query" << fixed
+         << setprecision(2) << ", radius scan " << t[0] * per
+         << ", radius grid " << t[1] * per << ", box scan " << t[2] * per
+         << ", box grid " << t[3] * per << ", grid build "
+         << setprecision(3) << t_build << " ms" << endl;
+  }
+  report("spatial", iterations, total);
+  return true;
+}
+
+// overlapping bands of aps, the report of all pairs per building by
+// shim::find_overlaps against comparing each pair, and 10 MHz band lookups by
+// the band index against a scan
+static bool bench_spectrum(const string &cfg, int iterations) {
+  shim_cfg c;
+  if (!c.map_config(cfg) || !c.parse_config()) {
+    cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+    return false;
+  }
+  shim &sh = shim::instance();
+  vector<string> buildings;
+  sh.for_each_building([&buildings](const object_config_ptr &b) {
+    buildings.push_back(b->get_key());
+  });
+  mt19937 rng(1);
+  vector<uint64_t> bands(100);
+  for (auto &b : bands)
+    b = enum_cbrs_base_khz + rng() % (enum_cbrs_n_channels * enum_cbrs_channel_khz);
+
+  double t[4] = { 0, 0, 0, 0 };
+  size_t n[4] = { 0, 0, 0, 0 };
+  for (int i = 0; i < iterations; ++i) {
+    // pairs overlapping at all, the blacklist is not applied here
+    auto start = bench_clock::now();
+    for (const auto &b : buildings) {
+      vector<ap_config_ptr> aps;
+      for (const auto &oc : sh.find_children(b))
+        if (ap_config_ptr ap = dynamic_pointer_cast<ap_config>(oc))
+          aps.push_back(ap);
+      for (size_t x = 0; x < aps.size(); ++x)
+        for (size_t y = x + 1; y < aps.size(); ++y) {
+          int64_t d = (int64_t)aps[x]->get_central_freq_khz() - aps[y]->get_central_freq_khz();
+          int64_t w = ((int64_t)aps[x]->get_radio_bandwidth_mhz()
+                       + aps[y]->get_radio_bandwidth_mhz()) * 500;
+          n[0] += (d < w && -d < w);
+        }
+    }
+    t[0] += elapsed_ms(start);
+    start = bench_clock::now();
+    for (const auto &b : buildings)
+      n[1] += sh.find_overlaps(b).size();
+    t[1] += elapsed_ms(start);
+
+    start = bench_clock::now();
+    for (uint64_t lo : bands)
+      n[2] += sh.find_in_band(lo, lo + 10000).size();
+    t[2] += elapsed_ms(start);
+    sh.create_band_index();
+    start = bench_clock::now();
+    for (uint64_t lo : bands)
+      n[3] += sh.find_in_band(lo, lo + 10000).size();
+    t[3] += elapsed_ms(start);
+    sh.drop_band_index();
+  }
+  if (n[2] != n[3] || n[1] > n[0]) {
+    cerr << "spectrum found " << n[3] << " aps in bands, scan " << n[2] << endl;
+    return false;
+  }
+  cout << "bench spectrum " << buildings.size() << " buildings, " << sh.size()
+       << " objects: ms/iteration" << fixed << setprecision(3)
+       << ", pairs compared " << t[0] / iterations << " (" << n[0] / iterations
+       << " overlaps), sweep " << t[1] / iterations << " (" << n[1] / iterations
+       << " not blacklisted); us/band, scan "
+       << t[2] * 1e3 / (bands.size() * iterations) << ", index "
+       << t[3] * 1e3 / (bands.size() * iterations) << endl;
+  report("spectrum", iterations, t[0] + t[1] + t[2] + t[3]);
+  return true;
+}
+
+// fleet analytics over all aps, sum of eirp_capability, histogram of
+// central_freq_khz by cbrs channel and count of indoor_site, by the objects
+// against the columns of the column store
+static bool bench_columns(const string &cfg, int iterations) {
+  shim_cfg c;
+  if (!c.map_config(cfg) || !c.parse_config()) {
+    cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+    return false;
+  }
+  shim &sh = shim::instance();
+  auto start = bench_clock::now();
+  sh.create_column_store();
+  double t_build = elapsed_ms(start);
+  const column_store *cs = sh.get_column_store();
+  const column<int> *eirp = cs->get_column<int>("eirp_capability");
+  const column<unsigned> *freq = cs->get_column<unsigned>("central_freq_khz");
+  const column<bool> *indoor = cs->get_column<bool>("indoor_site");
+  if (!eirp || !freq || !indoor) {
+    cerr << "columns of ap_config not found" << endl;
+    return false;
+  }
+
+  double t[2] = { 0, 0 };
+  int64_t sum[2] = { 0, 0 };
+  size_t n_indoor[2] = { 0, 0 };
+  vector<size_t> hist[2];
+  for (int i = 0; i < iterations; ++i) {
+    start = bench_clock::now();
+    sum[0] = 0;
+    n_indoor[0] = 0;
+    hist[0].assign(enum_cbrs_n_channels, 0);
+    sh.for_each_ap([&](const object_config_ptr &oc) {
+      if (ap_config *ap = dynamic_cast<ap_config *>(oc.get())) {
+        sum[0] += ap->get_eirp_capability();
+        n_indoor[0] += ap->get_indoor_site();
+        double b = ((double)ap->get_central_freq_khz() - enum_cbrs_base_khz)
+                   / enum_cbrs_channel_khz;
+        if (b >= 0 && b < enum_cbrs_n_channels)
+          ++hist[0][(size_t)b];
+      }
+    });
+    t[0] += elapsed_ms(start);
+
+    start = bench_clock::now();
+    sum[1] = cs->sum<int64_t>(*eirp);
+    n_indoor[1] = cs->count_if(*indoor, [](uint8_t v) { return v != 0; });
+    hist[1] = cs->histogram(*freq, enum_cbrs_base_khz, enum_cbrs_channel_khz,
+                            enum_cbrs_n_channels);
+    t[1] += elapsed_ms(start);
+  }
+  size_t n = cs->size();
+  sh.drop_column_store();
+  if (sum[0] != sum[1] || n_indoor[0] != n_indoor[1] || hist[0] != hist[1]) {
+    cerr << "columns sum " << sum[1] << " indoor " << n_indoor[1]
+         << ", objects sum " << sum[0] << " indoor " << n_indoor[0] << endl;
+    return false;
+  }
+  cout << "bench columns " << n << " aps: ms/iteration" << fixed
+       << setprecision(3) << ", objects " << t[0] / iterations << ", columns "
+       << t[1] / iterations << ", column build " << t_build << " ms" << endl;
+  report("columns", iterations, t[0] + t[1]);
+  return true;
+}
+
+// dedup ratio of each interned field of aps, and matching all aps against
+// the vendor, model and firmware of each of 100 aps by handles against by
+// string compare
+static bool bench_intern(const string &cfg, int iterations) {
+  shim_cfg c;
+  if (!c.map_config(cfg) || !c.parse_config()) {
+    cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+    return false;
+  }
+  shim &sh = shim::instance();
+  vector<ap_config_ptr> aps;
+  sh.for_each_ap([&aps](const object_config_ptr &oc) {
+    if (ap_config_ptr ap = dynamic_pointer_cast<ap_config>(oc))
+      aps.push_back(ap);
+  });
+  if (aps.empty()) {
+    cerr << "no aps in " << cfg << endl;
+    return false;
+  }
+  for (const auto &st : sh.get_intern_stats())
+    cout << "bench intern " << st.m_field << ": " << st.m_n_values << " values, "
+         << st.m_n_distinct << " distinct, ratio " << fixed << setprecision(1)
+         << (double)st.m_n_values / max(st.m_n_distinct, (size_t)1) << endl;
+
+  double t[2] = { 0, 0 };
+  size_t n[2] = { 0, 0 };
+  size_t step = max(aps.size() / 100, (size_t)1);
+  for (int i = 0; i < iterations; ++i) {
+    auto start = bench_clock::now();
+    for (size_t r = 0; r < aps.size(); r += step)
+      for (const auto &ap : aps)
+        n[0] += (ap->get_vendor() == aps[r]->get_vendor()
+                 && ap->get_model() == aps[r]->get_model()
+                 && ap->get_firmware_version() == aps[r]->get_firmware_version());
+    t[0] += elapsed_ms(start);
+    start = bench_clock::now();
+    for (size_t r = 0; r < aps.size(); r += step)
+      for (const auto &ap : aps)
+        n[1] += (ap->get_vendor().str() == aps[r]->get_vendor().str()
+                 && ap->get_model().str() == aps[r]->get_model().str()
+                 && ap->get_firmware_version().str() == aps[r]->get_firmware_version().str());
+    t[1] += elapsed_ms(start);
+  }
+  if (n[0] != n[1]) {
+    cerr << "intern matched " << n[0] << " aps, by string " << n[1] << endl;
+    return false;
+  }
+  intern_pool &pool = intern_pool::instance();
+  cout << "bench intern " << aps.size() << " aps, pool " << pool.size()
+       << " strings of " << pool.get_n_bytes() << " bytes: ms/iteration"
+       << fixed << setprecision(3) << ", match by handle " << t[0] / iterations
+       << ", by string " << t[1] / iterations << endl;
+  report("intern", iterations, t[0] + t[1]);
+  return true;
+}
+
+// walk of the list members of all aps, groups by index and blacklisted
+// channels of each channel by bit test against by iterating the set
+static bool bench_lists(const string &cfg, int iterations) {
+  shim_cfg c;
+  if (!c.map_config(cfg) || !c.parse_config()) {
+    cerr << "failed to map " << cfg << ", " << c.get_error() << endl;
+    return false;
+  }
+  shim &sh = shim::instance();
+  vector<ap_config_ptr> aps;
+  sh.for_each_ap([&aps](const object_config_ptr &oc) {
+    if (ap_config_ptr ap = dynamic_pointer_cast<ap_config>(oc))
+      aps.push_back(ap);
+  });
+  size_t n_inline = 0;
+  for (const auto &ap : aps)
+    n_inline += ap->get_group_types().is_inline() && ap->get_group_ids().is_inline()
+                && ap->get_meas_capabilities().is_inline();
+
+  double t[3] = { 0, 0, 0 };
+  size_t n[3] = { 0, 0, 0 };
+  for (int i = 0; i < iterations; ++i) {
+    auto start = bench_clock::now();
+    for (const auto &ap : aps) {
+      const string_vector &gts = ap->get_group_types();
+      const string_vector &gis = ap->get_group_ids();
+      for (size_t g = 0; g < gts.size() && g < gis.size(); ++g)
+        n[0] += gts[g].size() + gis[g].size();
+    }
+    t[0] += elapsed_ms(start);
+    start = bench_clock::now();
+    for (const auto &ap : aps) {
+      const channel_set &bl = ap->get_channel_blacklist();
+      for (int ch = 0; ch < enum_cbrs_n_channels; ++ch)
+        n[1] += bl.contains(ch);
+    }
+    t[1] += elapsed_ms(start);
+    start = bench_clock::now();
+    for (const auto &ap : aps) {
+      const channel_set &bl = ap->get_channel_blacklist();
+      for (int ch = 0; ch < enum_cbrs_n_channels; ++ch)
+        n[2] += find(bl.begin(), bl.end(), ch) != bl.end();
+    }
+    t[2] += elapsed_ms(start);
+  }
+  if (n[1] != n[2]) {
+    cerr << "lists blacklisted " << n[1] << " channels, by iterating " << n[2]
+         << endl;
+    return false;
+  }
+  cout << "bench lists " << aps.size() << " aps, " << n_inline
+       << " with inline groups: ms/iteration" << fixed << setprecision(3)
+       << ", groups " << t[0] / iterations << ", blacklist by bit "
+       << t[1] / iterations << ", by iterating " << t[2] / iterations << endl;
+  report("lists", iterations, t[0] + t[1] + t[2]);
+  return true;
+}
+
+// creation and teardown of 100k aps with all members bound, the cfg file is
+// not used
+static bool bench_create(int iterations) {
+  const size_t n = 100000;
+  double t[2] = { 0, 0 };
+  size_t n_members = 0;
+  for (int i = 0; i < iterations; ++i) {
+    vector<ap_config_ptr> aps;
+    aps.reserve(n);
+    auto start = bench_clock::now();
+    for (size_t k = 0; k < n; ++k)
+      aps.push_back(ap_config::create());
+    t[0] += elapsed_ms(start);
+    n_members += aps.back()->get_meta_info().size();
+    start = bench_clock::now();
+    aps.clear();
+    t[1] += elapsed_ms(start);
+  }
+  cout << "bench create " << n << " aps of " << n_members / iterations
+       << " members: ms/iteration" << fixed << setprecision(3) << ", create "
+       << t[0] / iterations << ", destroy " << t[1] / iterations << endl;
+  report("create", iterations, t[0] + t[1]);
+  return true;
+}
+
+bool bench_run(const string &name, const string &cfg, int iterations) {
+  if (iterations <= 0)
+    iterations = 1;
+  if (name == "parse")
+    return bench_parse(name, cfg, iterations, 0);
+  if (name == "pparse")
+    return bench_parse(name, cfg, iterations, thread::hardware_concurrency());
+  if (name == "load")
+    return bench_load(cfg, iterations);
+  if (name == "stream")
+    return bench_stream(cfg, iterations);
+  if (name == "mmap")
+    return bench_mmap(name, cfg, iterations, 0);
+  if (name == "shards")
+    return bench_mmap(name, cfg, iterations, thread::hardware_concurrency());
+  if (name == "cache")
+    return bench_cache(cfg, iterations);
+  if (name == "reload")
+    return bench_reload(cfg, iterations);
+  if (name == "lazy")
+    return bench_lazy(cfg, iterations);
+  if (name == "lookup")
+    return bench_lookup(iterations);
+  if (name == "walk")
+    return bench_walk(cfg, iterations);
+  if (name == "rcu")
+    return bench_rcu(cfg, iterations);
+  if (name == "query")
+    return bench_query(cfg, iterations);
+  if (name == "spatial")
+    return bench_spatial(iterations);
+  if (name == "spectrum")
+    return bench_spectrum(cfg, iterations);
+  if (name == "columns")
+    return bench_columns(cfg, iterations);
+  if (name == "intern")
+    return bench_intern(cfg, iterations);
+  if (name == "lists")
+    return bench_lists(cfg, iterations);
+  if (name == "create")
+    return bench_create(iterations);
+
+  cerr << "unknown benchmark, " << name << endl;
+  return false;
+}
+
+} // namespace project
@@ -0,0 +1,22 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <string>
+
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// bench
+// micro benchmarks of config loading and shim store operations
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// run named benchmark, return false if name is unknown or benchmark failed
+bool bench_run(const string &name, const string &cfg, int iterations);
+
+} // namespace project
+
+#endif // __BENCH_H__
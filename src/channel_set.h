@@ -0,0 +1,121 @@
+#ifndef __CHANNEL_SET_H__
+#define __CHANNEL_SET_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "const.h"
+
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// channel_set
+// set of cbrs channels, e.g. channel_blacklist of ap, as one bit per channel.
+// Membership and set operations are a few instructions, channels are visited
+// in ascending order and each is kept once
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class channel_set {
+  static_assert(enum_cbrs_n_channels <= 32, "channels do not fit the mask");
+
+public:
+  typedef int value_type;
+
+  // channels in ascending order
+  class iterator {
+  public:
+    typedef forward_iterator_tag iterator_category;
+    typedef int value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const int *pointer;
+    typedef int reference;
+
+    explicit iterator(uint32_t bits) : m_bits(bits) {}
+    int operator*() const { return __builtin_ctz(m_bits); }
+    iterator &operator++() {
+      m_bits &= m_bits - 1;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator i = *this;
+      ++*this;
+      return i;
+    }
+    bool operator==(const iterator &rhs) const { return m_bits == rhs.m_bits; }
+    bool operator!=(const iterator &rhs) const { return m_bits != rhs.m_bits; }
+
+  private:
+    uint32_t m_bits; // channels not visited yet
+  };
+  typedef iterator const_iterator;
+
+  channel_set() : m_bits(0) {}
+  channel_set(initializer_list<int> l) : m_bits(0) {
+    for (int ch : l)
+      insert(ch);
+  }
+  static channel_set from_mask(uint32_t mask) {
+    channel_set s;
+    s.m_bits = mask & all_mask();
+    return s;
+  }
+
+  // channel must be one of the cbrs channels, i.e. 0 to 29
+  void insert(int ch) { m_bits |= bit(ch); }
+  void push_back(int ch) { insert(ch); }
+  void erase(int ch) { m_bits &= ~bit(ch); }
+  bool contains(int ch) const { return is_channel(ch) && (m_bits >> ch & 1); }
+  void clear() { m_bits = 0; }
+
+  size_t size() const { return __builtin_popcount(m_bits); }
+  bool empty() const { return m_bits == 0; }
+  uint32_t mask() const { return m_bits; }
+
+  iterator begin() const { return iterator(m_bits); }
+  iterator end() const { return iterator(0); }
+
+  channel_set operator|(const channel_set &rhs) const { return from_mask(m_bits | rhs.m_bits); }
+  channel_set operator&(const channel_set &rhs) const { return from_mask(m_bits & rhs.m_bits); }
+  channel_set operator-(const channel_set &rhs) const { return from_mask(m_bits & ~rhs.m_bits); }
+  channel_set operator~() const { return from_mask(~m_bits); }
+  channel_set &operator|=(const channel_set &rhs) {
+    m_bits |= rhs.m_bits;
+    return *this;
+  }
+  channel_set &operator&=(const channel_set &rhs) {
+    m_bits &= rhs.m_bits;
+    return *this;
+  }
+  bool operator==(const channel_set &rhs) const { return m_bits == rhs.m_bits; }
+  bool operator!=(const channel_set &rhs) const { return m_bits != rhs.m_bits; }
+
+  static bool is_channel(int ch) { return ch >= 0 && ch < enum_cbrs_n_channels; }
+  static string not_channel(int ch) {
+    return "channel " + to_string(ch) + " is not a cbrs channel";
+  }
+  static uint32_t all_mask() {
+    return enum_cbrs_n_channels == 32 ? ~0u : (1u << enum_cbrs_n_channels) - 1;
+  }
+
+private:
+  static uint32_t bit(int ch) {
+    if (!is_channel(ch))
+      throw out_of_range(not_channel(ch));
+    return 1u << ch;
+  }
+
+  uint32_t m_bits;
+
+}; // class channel_set
+
+} // namespace project
+
+#endif // __CHANNEL_SET_H__
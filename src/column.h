@@ -0,0 +1,212 @@
+#ifndef __COLUMN_H__
+#define __COLUMN_H__
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "const.h"
+#include "id_alloc.h"
+
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// column
+// values of one scalar field in a contiguous array indexed by slot, i.e. the
+// index of map id. Slots without a row hold the zero value, so that sums
+// need no mask
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// element of column of T, bool is kept as a byte instead of vector<bool> bits
+template <typename T> struct column_elem { typedef T type; };
+template <> struct column_elem<bool> { typedef uint8_t type; };
+
+class column_base {
+public:
+  explicit column_base(var_type_t vtype) : m_vtype(vtype) {}
+  virtual ~column_base() {}
+
+  var_type_t get_vtype() const { return m_vtype; }
+
+  virtual void resize(size_t) = 0;
+  // var points to a member of the type of the column
+  virtual void set(uint32_t, const void *) = 0;
+  virtual void reset(uint32_t) = 0;
+
+private:
+  var_type_t m_vtype;
+
+}; // class column_base
+
+template <typename T> class column : public column_base {
+public:
+  typedef typename column_elem<T>::type elem_t;
+
+  explicit column(var_type_t vtype) : column_base(vtype) {}
+
+  virtual void resize(size_t n) { m_values.resize(n, elem_t()); }
+  virtual void set(uint32_t slot, const void *var) {
+    m_values[slot] = (elem_t)*static_cast<const T *>(var);
+  }
+  virtual void reset(uint32_t slot) { m_values[slot] = elem_t(); }
+
+  const elem_t *data() const { return m_values.data(); }
+  size_t size() const { return m_values.size(); }
+
+private:
+  vector<elem_t> m_values;
+
+}; // class column
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// column_store
+// columns of fields of one object type, one row per live object. Rows are
+// copies, the objects stay the source and are copied in on insert and on
+// update of a field. Kernels run over whole columns in slot order with no
+// branch per slot but the predicate, so that the compiler can vectorize them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class column_store {
+public:
+  // column of field, false if there is one already
+  template <typename T> bool add_column(const string &field, var_type_t vtype) {
+    if (m_columns.count(field))
+      return false;
+    column_base *c = new column<T>(vtype);
+    c->resize(m_ids.size());
+    m_columns[field].reset(c);
+    return true;
+  }
+  bool has_column(const string &field) const { return m_columns.count(field) != 0; }
+  column_base *find_column(const string &field) {
+    auto it = m_columns.find(field);
+    return it != m_columns.end() ? it->second.get() : nullptr;
+  }
+  // null if there is no column of field or it is not of T
+  template <typename T> const column<T> *get_column(const string &field) const {
+    auto it = m_columns.find(field);
+    return it != m_columns.end() ? dynamic_cast<const column<T> *>(it->second.get())
+                                 : nullptr;
+  }
+  // f(field, column_base &) for each column
+  template <typename F> void for_each_column(F f) {
+    for (auto &c : m_columns)
+      f(c.first, *c.second);
+  }
+
+  // row of id, the columns are reset to the zero value, returns its slot
+  uint32_t insert(uint64_t id) {
+    uint32_t slot = id_allocator::index_of(id);
+    if (slot >= m_ids.size()) {
+      size_t n = max((size_t)slot + 1, m_ids.size() * 2);
+      m_ids.resize(n, 0);
+      m_live.resize(n, 0);
+      for (auto &c : m_columns)
+        c.second->resize(n);
+    }
+    if (!m_live[slot])
+      ++m_size;
+    else
+      for (auto &c : m_columns)
+        c.second->reset(slot);
+    m_ids[slot] = id;
+    m_live[slot] = 1;
+    return slot;
+  }
+
+  // false if id has no row
+  bool erase(uint64_t id) {
+    int slot = find(id);
+    if (slot < 0)
+      return false;
+    for (auto &c : m_columns)
+      c.second->reset(slot);
+    m_ids[slot] = 0;
+    m_live[slot] = 0;
+    --m_size;
+    return true;
+  }
+
+  // slot of id, -1 if it has no row
+  int find(uint64_t id) const {
+    uint32_t slot = id_allocator::index_of(id);
+    return (slot < m_ids.size() && m_ids[slot] == id) ? (int)slot : -1;
+  }
+
+  size_t size() const { return m_size; }
+  size_t n_slots() const { return m_ids.size(); }
+  uint64_t id_at(uint32_t slot) const { return m_ids[slot]; }
+
+  void clear() {
+    m_columns.clear();
+    m_ids.clear();
+    m_live.clear();
+    m_size = 0;
+  }
+
+  // sum of column over live rows in R, e.g. int64_t for int columns
+  template <typename R, typename T> R sum(const column<T> &c) const {
+    const typename column<T>::elem_t *v = c.data();
+    R r = R();
+    for (size_t i = 0, n = c.size(); i < n; ++i)
+      r += (R)v[i];
+    return r;
+  }
+
+  // live rows whose value matches pred(value)
+  template <typename T, typename P> size_t count_if(const column<T> &c, P pred) const {
+    const typename column<T>::elem_t *v = c.data();
+    const uint8_t *live = m_live.data();
+    size_t r = 0;
+    for (size_t i = 0, n = c.size(); i < n; ++i)
+      r += live[i] & (uint8_t)(pred(v[i]) ? 1 : 0);
+    return r;
+  }
+
+  // ids of live rows whose value matches pred(value), in slot order
+  template <typename T, typename P>
+  vector<uint64_t> filter(const column<T> &c, P pred) const {
+    const typename column<T>::elem_t *v = c.data();
+    vector<uint64_t> r;
+    for (size_t i = 0, n = c.size(); i < n; ++i)
+      if (m_live[i] && pred(v[i]))
+        r.push_back(m_ids[i]);
+    return r;
+  }
+
+  // counts of live rows in n_bins bins of width from lo, values outside are
+  // not counted
+  template <typename T>
+  vector<size_t> histogram(const column<T> &c, double lo, double width,
+                           size_t n_bins) const {
+    const typename column<T>::elem_t *v = c.data();
+    vector<size_t> r(n_bins, 0);
+    if (!(width > 0))
+      return r;
+    for (size_t i = 0, n = c.size(); i < n; ++i) {
+      double b = ((double)v[i] - lo) / width;
+      if (m_live[i] && b >= 0 && b < n_bins)
+        ++r[(size_t)b];
+    }
+    return r;
+  }
+
+private:
+  map<string, unique_ptr<column_base>> m_columns;
+  vector<uint64_t> m_ids;   // map id of row by slot, 0 if none
+  vector<uint8_t> m_live;   // 1 if slot has a row
+  size_t m_size = 0;
+
+}; // class column_store
+
+} // namespace project
+
+#endif // __COLUMN_H__
@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <exception>
 #include <iostream>
+#include <thread>
 #include <typeinfo>
 #include <sstream>
 
@@ -293,7 +297,7 @@ bool ap_cfg::parse_config() {
           const char *category = (const char *)c.lookup("category");
           const char *call_sign = (const char *)c.lookup("call_sign");
           const settings &mcs = c["meas_capabilities"];
-          list<string> meas_caps;
+          string_vector meas_caps;
           for (const auto &m : mcs)
             meas_caps.push_back((const char *)m);
           const char *radio_technology =
@@ -320,7 +324,7 @@ bool ap_cfg::parse_config() {
           int antenna_beamwidth = (int)c.lookup("antenna_beamwidth");
           const char *antenna_model = (const char *)c.lookup("antenna_model");
           const settings &gs = c["groups"];
-          list<string> gts, gis;
+          string_vector gts, gis;
           for (const auto &g : gs) {
             gts.push_back((const char *)g.lookup("type"));
             gis.push_back((const char *)g.lookup("id"));
@@ -375,7 +379,7 @@ bool ap_cfg::parse_config() {
           if (c.exists("hbt_interval"))
             cc->set_hbt_interval((int)c.lookup("hbt_interval"));
           if (c.exists("channel_blacklist")) {
-            list<int> blacklist;
+            channel_set blacklist;
             const settings &bs = c["channel_blacklist"];
             for (const auto &b : bs)
               blacklist.push_back((int)b);
@@ -813,8 +817,7 @@ bool ap_cfg::build_config(const string &ofn) {
         cs_1.add("call_sign", settings::TypeString) = sh_cc->get_call_sign();
         cs_1.add("meas_capabilities", settings::TypeArray);
         settings &mcs = cs_1["meas_capabilities"];
-        list<string> meas_caps;
-        meas_caps = sh_cc->get_meas_capabilities();
+        const string_vector &meas_caps = sh_cc->get_meas_capabilities();
         for (const auto &m : meas_caps) {
           mcs.add(settings::TypeString) = m;
         }
@@ -839,22 +842,13 @@ bool ap_cfg::build_config(const string &ofn) {
         cs_1.add("antenna_model", settings::TypeString) = sh_cc->get_antenna_model();
         cs_1.add("groups", settings::TypeList);
         settings &groups = cs_1["groups"];
-        list<string> gts, gis;
-        gts = sh_cc->get_group_types();
-        gis = sh_cc->get_group_ids();
+        const string_vector &gts = sh_cc->get_group_types();
+        const string_vector &gis = sh_cc->get_group_ids();
         int group_length = gts.size();
         for (int i = 0; i < group_length; i++) {
           settings &gp = groups.add(settings::TypeGroup);
-          list<string>::iterator it_type, it_id;
-          it_type = gts.begin();
-          it_id = gis.begin();
-          advance(it_type, i);
-          advance(it_id, i);
-          string type, id;
-          type = *it_type;
-          id = *it_id;
-          gp.add("type", settings::TypeString) = type;
-          gp.add("id", settings::TypeString) = id;
+          gp.add("type", settings::TypeString) = gts[i];
+          gp.add("id", settings::TypeString) = gis[i];
         }
         cs_1.add("protected_header", settings::TypeString) = sh_cc->get_protected_header();
         cs_1.add("encoded_cpi_signed_data", settings::TypeString) = sh_cc->get_encoded_cpi_signed_data();
@@ -865,8 +859,8 @@ bool ap_cfg::build_config(const string &ofn) {
         cs_1.add("hbt_interval", settings::TypeInt) = sh_cc->get_hbt_interval();
         cs_1.add("channel_blacklist", settings::TypeList);
         settings &bs = cs_1["channel_blacklist"];
-        list<int> blacklist = sh_cc->get_channel_blacklist();
-        for (const auto &b : blacklist) {
+        const channel_set &blacklist = sh_cc->get_channel_blacklist();
+        for (int b : blacklist) {
           bs.add(settings::TypeInt) = b;
         }
         cs_1.add("ap_cert", settings::TypeString) = sh_cc->get_ap_cert();
@@ -904,189 +898,375 @@ string shim_cfg::get_parent_path(const settings &node) {
     return getRoot().getPath();
 }
 
-void shim_cfg::traverse(const settings &node) {
-  string node_name = node.getName();
-  for (const auto &n : node) {
-    object_config_ptr oc = nullptr;
-    meta_map *mm = nullptr;
-    member_map *bm = nullptr;
-    if (node_name == "sites") {
-      auto dc = site_config::create();
-      mm = &(dc->get_meta());
-      bm = &(dc->get_members());
-      oc = dc;
+// "[%d]" of groups path formatted with the element index, for error message
+static string element_path(const string &node, int i) {
+  char path[BUFSIZ] = { 0 };
+  snprintf(path, sizeof(path), node.c_str(), i);
+  return path;
+}
+
+template <typename T>
+void shim_cfg::decode_scalar(const settings &n, const field_decoder &d,
+                             const member_t &b) {
+  const settings *s = resolve(n, d.m_path);
+  if (s) {
+    T val = *s;
+    b.m_xetter->set(b.m_var, std::move(val));
+  }
+  else
+    if (d.m_meta->m_trait == enum_var_required)
+      throw runtime_error(*d.m_var + " is required");
+}
+
+template <typename C>
+void shim_cfg::decode_list(const settings &n, const field_decoder &d,
+                           const member_t &b) {
+  const settings *sn = resolve(n, d.m_path);
+  if (d.m_groups) {
+    // handle the non-leaf list, groups
+    if (!sn)
+      throw runtime_error(*d.m_var + " is required");
+    C vals;
+    int len = sn->getLength();
+    for (int i = 0; i < len; ++i)
+    {
+        const settings *e = resolve((*sn)[i], d.m_element);
+        if (!e)
+          throw runtime_error(element_path(d.m_meta->m_node, i) + " is required");
+        vals.push_back((typename C::value_type)*e);
     }
-    else if (node_name == "buildings") {
-      auto tc = building_config::create();
-      mm = &(tc->get_meta());
-      bm = &(tc->get_members());
-      oc = tc;
-    } 
-    else if (node_name == "aps") {
-      auto cc = ap_config::create();
-      mm = &(cc->get_meta());
-      bm = &(cc->get_members());
-      oc = cc;
+    b.m_xetter->set(b.m_var, std::move(vals));
+  }
+  else {
+    // handle the leaf list, channel-blacklist
+    if (sn) {
+      C vals;
+      for (const auto &e : *sn)
+        vals.push_back((typename C::value_type)e);
+      b.m_xetter->set(b.m_var, std::move(vals));
     }
     else
-      throw runtime_error(string("unknown node, ") + node.getName());
-    // set version
-    oc->set_ver(m_ver);
-
-    for (auto &v : *mm) {
-      const string &var = v.first;
-      const meta_t &t = v.second;
-      const member_t &b = (*bm)[var];
-      if (t.m_type == "string") {
-        if (n.exists(t.m_node)) {
-          string val = n.lookup(t.m_node);
-          b.m_xetter->set(b.m_var, val);
-        }
-        else
-          if (t.m_trait == enum_var_required)
-            throw runtime_error(string(var) + "is required");
-      }
-      else if (t.m_type == "bool") {
-        if (n.exists(t.m_node)) {
-          bool val = n.lookup(t.m_node);
-          b.m_xetter->set(b.m_var, val);
-        }
-        else
-          if (t.m_trait == enum_var_required)
-            throw runtime_error(string(var) + "is required");
-      }
-      else if (t.m_type == "int") {
-        if (n.exists(t.m_node)) {
-          int val = n.lookup(t.m_node);
-          b.m_xetter->set(b.m_var, val);
-        }
-        else
-          if (t.m_trait == enum_var_required)
-            throw runtime_error(string(var) + "is required");
-      }
-      else if (t.m_type == "int32_t") {
-        if (n.exists(t.m_node)) {
-          int32_t val = n.lookup(t.m_node);
-          b.m_xetter->set(b.m_var, val);
-        }
-        else
-          if (t.m_trait == enum_var_required)
-            throw runtime_error(string(var) + "is required");
-      }
-      else if (t.m_type == "long") {
-        if (n.exists(t.m_node)) {
-          long val = n.lookup(t.m_node);
-          b.m_xetter->set(b.m_var, val);
-        }
-        else
-          if (t.m_trait == enum_var_required)
-            throw runtime_error(string(var) + "is required");
-      }
-      else if (t.m_type == "unsigned") {
-        if (n.exists(t.m_node)) {
-          unsigned val = n.lookup(t.m_node);
-          b.m_xetter->set(b.m_var, val);
-        }
-        else
-          if (t.m_trait == enum_var_required)
-            throw runtime_error(string(var) + "is required");
-      }
-      else if (t.m_type == "double") {
-        if (n.exists(t.m_node)) {
-          double val = n.lookup(t.m_node);
-          b.m_xetter->set(b.m_var, val);
-        }
-        else
-          if (t.m_trait == enum_var_required)
-            throw runtime_error(string(var) + "is required");
-      }
-      else if (t.m_type == "list<int>") {
-        size_t pos = t.m_node.find("[");
-        if (pos != string::npos) {
-          // handle the non-leaf list
-          list<int> vals;
-          const settings &sn = n.lookup(t.m_node.substr(0, pos));
-          int len = sn.getLength();
-          for (int i = 0; i < len; ++i)
-          {
-              char path[BUFSIZ] = { 0 };
-              snprintf(path, sizeof(path), t.m_node.c_str(), i);
-              vals.push_back((int)n.lookup(path));
-          }
-          b.m_xetter->set(b.m_var, vals);
-        }
-        else {
-          // handle the leaf list, channel-blacklist
-          if (n.exists(t.m_node)) {
-            list<int> vals;
-            const settings &sn = n.lookup(t.m_node);
-            for (const auto &e : sn)
-              vals.push_back((int)e);
-            b.m_xetter->set(b.m_var, vals);
-          }
-          else
-            if (t.m_trait == enum_var_required)
-              throw runtime_error(string(var) + " is required");
-        }
-      }
-      else if (t.m_type == "list<string>") {
-        size_t pos = t.m_node.find("[");
-        if (pos != string::npos) {
-          // handle the non-leaf list
-          list<string> vals;
-          const settings &sn = n.lookup(t.m_node.substr(0, pos));
-          int len = sn.getLength();
-          for (int i = 0; i < len; ++i)
-          {
-              char path[BUFSIZ] = { 0 };
-              snprintf(path, sizeof(path), t.m_node.c_str(), i);
-              vals.push_back((string)n.lookup(path));
-          }
-          b.m_xetter->set(b.m_var, vals);
-        }
-        else {
-          // handle the leaf list, channel-blacklist
-          if (n.exists(t.m_node)) {
-            list<string> vals;
-            const settings &sn = n.lookup(t.m_node);
-            for (const auto &e : sn)
-              vals.push_back((string)e);
-            b.m_xetter->set(b.m_var, vals);
-          }
-          else
-            if (t.m_trait == enum_var_required)
-              throw runtime_error(string(var) + " is required");
-        }
+      if (d.m_meta->m_trait == enum_var_required)
+        throw runtime_error(*d.m_var + " is required");
+  }
+}
+
+void shim_cfg::decode_unknown(const settings &, const field_decoder &d,
+                              const member_t &) {
+  cerr << "unknown type, " << d.m_meta->m_type << "; title, "
+       << d.m_meta->m_node << endl;
+}
+
+template <typename T>
+void shim_cfg::decode_scalar(const cfg_tree &tr, int n, const field_decoder &d,
+                             const member_t &b) {
+  int idx = resolve(tr, n, d.m_path);
+  if (idx >= 0) {
+    T val{};
+    tr.get(idx, val);
+    b.m_xetter->set(b.m_var, std::move(val));
+  }
+  else
+    if (d.m_meta->m_trait == enum_var_required)
+      throw runtime_error(*d.m_var + " is required");
+}
+
+template <typename C>
+void shim_cfg::decode_list(const cfg_tree &tr, int n, const field_decoder &d,
+                           const member_t &b) {
+  int sn = resolve(tr, n, d.m_path);
+  if (d.m_groups) {
+    // handle the non-leaf list, groups
+    if (sn < 0)
+      throw runtime_error(*d.m_var + " is required");
+    C vals;
+    int i = 0;
+    for (int c = tr.at(sn).m_first_child; c >= 0; c = tr.at(c).m_next_sibling, ++i)
+    {
+        int e = resolve(tr, c, d.m_element);
+        if (e < 0)
+          throw runtime_error(element_path(d.m_meta->m_node, i) + " is required");
+        typename C::value_type val{};
+        tr.get(e, val);
+        vals.push_back(val);
+    }
+    b.m_xetter->set(b.m_var, std::move(vals));
+  }
+  else {
+    // handle the leaf list, channel-blacklist
+    if (sn >= 0) {
+      C vals;
+      for (int e = tr.at(sn).m_first_child; e >= 0; e = tr.at(e).m_next_sibling) {
+        typename C::value_type val{};
+        tr.get(e, val);
+        vals.push_back(val);
       }
-      else
-        cerr << "unknown type, " << t.m_type << "; title, " << t.m_node << endl;
+      b.m_xetter->set(b.m_var, std::move(vals));
     }
-    if (node_name == "sites") {
-      shim::instance().insert_config(oc);
-      traverse(n["buildings"]);
+    else
+      if (d.m_meta->m_trait == enum_var_required)
+        throw runtime_error(*d.m_var + " is required");
+  }
+}
+
+void shim_cfg::decode_unknown(const cfg_tree &, int, const field_decoder &d,
+                              const member_t &) {
+  cerr << "unknown type, " << d.m_meta->m_type << "; title, "
+       << d.m_meta->m_node << endl;
+}
+
+// split meta_t::m_node at '.', segments after [%d] go to the element path
+void shim_cfg::compile_path(field_decoder &d) {
+  const string &node = d.m_meta->m_node;
+  node_path *p = &d.m_path;
+  d.m_groups = false;
+  size_t prev = 0;
+  while (prev <= node.size()) {
+    size_t pos = node.find('.', prev);
+    if (pos == string::npos)
+      pos = node.size();
+    string tok = node.substr(prev, pos - prev);
+    prev = pos + 1;
+    if (tok.empty())
+      continue;
+    if (tok == "[%d]") {
+      d.m_groups = true;
+      p = &d.m_element;
+      continue;
     }
-    else if (node_name == "buildings") {
-            
-      // handle composed field of name
-      string site = get_parent_path(n);
-      building_config_ptr tc = std::dynamic_pointer_cast<building_config>(oc);
-      tc->set_site_name((string)getRoot().lookup(site + ".name"));
-      shim::instance().insert_config(oc);
-      traverse(n["aps"]);
+    path_segment seg = { tok, -1 };
+    if (tok[0] == '[')
+      seg.m_index = atoi(tok.c_str() + 1);
+    p->push_back(seg);
+  }
+}
+
+// one pass over the children for each segment, no path parsing
+const settings *shim_cfg::resolve(const settings &n, const node_path &p) {
+  const settings *s = &n;
+  for (const auto &seg : p) {
+    if (seg.m_index >= 0) {
+      if (!s->isAggregate() || seg.m_index >= s->getLength())
+        return nullptr;
+      s = &(*s)[seg.m_index];
+      continue;
     }
-    else if (node_name == "aps") {
-      // handle composed fields of parent names and ap name
-      string building = get_parent_path(n);  
-      settings &c = getRoot().lookup(building);
-      string site = get_parent_path(c);
-      ap_config_ptr cc = std::dynamic_pointer_cast<ap_config>(oc);
-      cc->set_site_name((string)getRoot().lookup(site + ".name"));
-      cc->set_building_name((string)getRoot().lookup(building + ".name"));
-      cc->set_name(cc->get_fcc_id() + ":" + cc->get_serial_number());
-      shim::instance().insert_config(oc);
+    if (!s->isGroup())
+      return nullptr;
+    const settings *c = nullptr;
+    for (int i = 0, len = s->getLength(); i < len && !c; ++i) {
+      const settings &e = (*s)[i];
+      if (seg.m_name == e.getName())
+        c = &e;
+    }
+    if (!c)
+      return nullptr;
+    s = c;
+  }
+  return s;
+}
+
+int shim_cfg::resolve(const cfg_tree &tr, int n, const node_path &p) {
+  for (const auto &seg : p) {
+    if (n < 0)
+      break;
+    if (seg.m_index >= 0)
+      n = (tr.at(n).m_type >= enum_cfg_group ? tr.child(n, seg.m_index) : -1);
+    else
+      n = (tr.at(n).m_type == enum_cfg_group ? tr.child(n, seg.m_name) : -1);
+  }
+  return n;
+}
+
+// build the decoder table of a class once, in the order of its meta info
+const shim_cfg::decoder_table &shim_cfg::get_decoders(meta_map &mm) {
+  static map<meta_map *, decoder_table> s_tables;
+  auto it = s_tables.find(&mm);
+  if (it != s_tables.end() && !it->second.empty())
+    return it->second;
+
+  decoder_table &dt = s_tables[&mm];
+  dt.clear();
+
+  for (const auto &v : mm) {
+    field_decoder fd = { &v.first, &v.second, nullptr, nullptr,
+                         node_path(), node_path(), false };
+    compile_path(fd);
+    switch (v.second.m_vtype) {
+      case enum_type_string:
+      case enum_type_istring:
+        fd.m_decode = &decode_scalar<string>;
+        fd.m_decode_tree = &decode_scalar<string>;
+        break;
+      case enum_type_bool:
+        fd.m_decode = &decode_scalar<bool>;
+        fd.m_decode_tree = &decode_scalar<bool>;
+        break;
+      case enum_type_int:
+        fd.m_decode = &decode_scalar<int>;
+        fd.m_decode_tree = &decode_scalar<int>;
+        break;
+      case enum_type_long:
+        fd.m_decode = &decode_scalar<long>;
+        fd.m_decode_tree = &decode_scalar<long>;
+        break;
+      case enum_type_unsigned:
+        fd.m_decode = &decode_scalar<unsigned>;
+        fd.m_decode_tree = &decode_scalar<unsigned>;
+        break;
+      case enum_type_double:
+        fd.m_decode = &decode_scalar<double>;
+        fd.m_decode_tree = &decode_scalar<double>;
+        break;
+      case enum_type_list_int:
+        fd.m_decode = &decode_list<list<int>>;
+        fd.m_decode_tree = &decode_list<list<int>>;
+        break;
+      case enum_type_list_string:
+        fd.m_decode = &decode_list<list<string>>;
+        fd.m_decode_tree = &decode_list<list<string>>;
+        break;
+      case enum_type_channel_set:
+        fd.m_decode = &decode_list<channel_set>;
+        fd.m_decode_tree = &decode_list<channel_set>;
+        break;
+      case enum_type_string_vector:
+        fd.m_decode = &decode_list<string_vector>;
+        fd.m_decode_tree = &decode_list<string_vector>;
+        break;
+      default:
+        fd.m_decode = &decode_unknown;
+        fd.m_decode_tree = &decode_unknown;
+        break;
+    }
+    dt.push_back(std::move(fd));
+  }
+  return dt;
+}
+
+// create object config of list node, i.e. sites, buildings or aps
+object_config_ptr shim_cfg::create_object(const string &node_name,
+                                          meta_map *&mm) {
+  object_config_ptr oc = nullptr;
+  if (node_name == "sites") {
+    auto dc = site_config::create();
+    mm = &(dc->get_meta());
+    oc = dc;
+  }
+  else if (node_name == "buildings") {
+    auto tc = building_config::create();
+    mm = &(tc->get_meta());
+    oc = tc;
+  }
+  else if (node_name == "aps") {
+    auto cc = ap_config::create();
+    mm = &(cc->get_meta());
+    oc = cc;
+  }
+  else
+    throw runtime_error(string("unknown node, ") + node_name);
+  // set version
+  oc->set_ver(m_ver);
+  return oc;
+}
+
+// insert object into shim, or collect it if objs is given
+static void commit_object(const object_config_ptr &oc,
+                          vector<object_config_ptr> *objs) {
+  if (objs)
+    objs->push_back(oc);
+  else
+    shim::instance().insert_config(oc);
+}
+
+void shim_cfg::traverse(const settings &node,
+                        vector<object_config_ptr> *objs /* = nullptr */) {
+  string node_name = node.getName();
+  for (const auto &n : node)
+    traverse_node(node_name, n, objs);
+}
+
+void shim_cfg::traverse_node(const string &node_name, const settings &n,
+                             vector<object_config_ptr> *objs) {
+  meta_map *mm = nullptr;
+  object_config_ptr oc = create_object(node_name, mm);
+
+  for (const auto &d : get_decoders(*mm))
+    d.m_decode(n, d, oc->get_member(*d.m_meta));
+  if (node_name == "sites") {
+    commit_object(oc, objs);
+    traverse(n["buildings"], objs);
+  }
+  else if (node_name == "buildings") {
+    // handle composed field of name
+    string site = get_parent_path(n);
+    building_config_ptr tc = std::dynamic_pointer_cast<building_config>(oc);
+    tc->set_site_name((string)getRoot().lookup(site + ".name"));
+    commit_object(oc, objs);
+    traverse(n["aps"], objs);
+  }
+  else if (node_name == "aps") {
+    // handle composed fields of parent names and ap name
+    string building = get_parent_path(n);
+    settings &c = getRoot().lookup(building);
+    string site = get_parent_path(c);
+    ap_config_ptr cc = std::dynamic_pointer_cast<ap_config>(oc);
+    cc->set_site_name((string)getRoot().lookup(site + ".name"));
+    cc->set_building_name((string)getRoot().lookup(building + ".name"));
+    cc->set_name(cc->get_fcc_id() + ":" + cc->get_serial_number());
+    commit_object(oc, objs);
+  }
+}
+
+// create one object of each class on this thread so that the meta info and
+// decoder tables are complete before workers share them
+void shim_cfg::prepare_decoders() {
+  bool deferred = object_config::is_id_deferred();
+  object_config::is_id_deferred() = true;
+  for (const char *node_name : { "sites", "buildings", "aps" }) {
+    meta_map *mm = nullptr;
+    create_object(node_name, mm);
+    get_decoders(*mm);
+  }
+  object_config::is_id_deferred() = deferred;
+}
+
+// decode each site subtree on a worker thread with ids deferred, then assign
+// ids and insert in the order of sites, same as the serial traverse
+void shim_cfg::traverse_parallel(const settings &sites) {
+  int n_sites = sites.getLength();
+  vector<vector<object_config_ptr>> objs(n_sites);
+  vector<exception_ptr> errors(n_sites);
+  atomic<int> next(0);
+
+  prepare_decoders();
+  auto worker = [&]() {
+    object_config::is_id_deferred() = true;
+    for (int i = next++; i < n_sites; i = next++) {
+      try {
+        traverse_node(sites.getName(), sites[i], &objs[i]);
+      } catch (...) {
+        errors[i] = current_exception();
+      }
+    }
+  };
+
+  vector<thread> workers;
+  unsigned n_workers = min(m_n_threads, (unsigned)n_sites);
+  for (unsigned i = 0; i < n_workers; ++i)
+    workers.emplace_back(worker);
+  for (auto &w : workers)
+    w.join();
+
+  shim &sh = shim::instance();
+  for (int i = 0; i < n_sites; ++i) {
+    if (errors[i])
+      rethrow_exception(errors[i]);
+    for (const auto &oc : objs[i]) {
+      oc->assign_id();
+      sh.insert_config(oc);
     }
   }
-  
 }
 
 bool shim_cfg::parse_config() {
@@ -1097,8 +1277,25 @@ bool shim_cfg::parse_config() {
     shim &sh = shim::instance();
     (void)sh;
     reset_error();
-    traverse(getRoot()["sites"]);
+    if (m_mapped) {
+      int sites = m_tree->child(0, "sites");
+      if (sites < 0)
+        throw runtime_error("sites not found");
+      for (auto &l : m_loaded)
+        l.clear();
+      m_hashes.clear();
+      hash_records(sites, 0, string(), string());
+      if (m_n_threads > 1)
+        traverse_tree_parallel(sites);
+      else
+        traverse_tree(sites, string(), string(), nullptr, m_loaded, nullptr);
+    }
+    else if (m_n_threads > 1)
+      traverse_parallel(getRoot()["sites"]);
+    else
+      traverse(getRoot()["sites"]);
 
+    sh.publish();
     return true;
   } catch (const exception_setting &es) {
     ostringstream oss;
@@ -1106,9 +1303,770 @@ bool shim_cfg::parse_config() {
         << ", " << es.getPath();
     m_error = oss.str();
     return false;
+  } catch (const exception &e) {
+    ostringstream oss;
+    oss << "exception occurred during parsing settings, " << e.what();
+    m_error = oss.str();
+    return false;
+  }
+}
+
+// value type a member is decoded from, libconfig does not convert between
+// number types
+static cfg_type_t expected_type(var_type_t vtype) {
+  switch (vtype) {
+    case enum_type_string:
+    case enum_type_istring:
+    case enum_type_list_string:
+    case enum_type_string_vector: return enum_cfg_string;
+    case enum_type_bool: return enum_cfg_bool;
+    case enum_type_int:
+    case enum_type_unsigned:
+    case enum_type_list_int:
+    case enum_type_channel_set: return enum_cfg_int;
+    case enum_type_long:
+      return sizeof(long) == sizeof(long long) ? enum_cfg_int64 : enum_cfg_int;
+    case enum_type_double: return enum_cfg_float;
+    default: return enum_cfg_none;
+  }
+}
+
+static string type_mismatch(cfg_type_t type) {
+  static const char *s_names[] = { "none", "int", "int64", "float", "string",
+                                   "bool", "group", "array", "list" };
+  return string("type mismatch, ") + s_names[type] + " expected";
+}
+
+static bool is_list_type(var_type_t vtype) {
+  return vtype == enum_type_list_int || vtype == enum_type_list_string ||
+         vtype == enum_type_channel_set || vtype == enum_type_string_vector;
+}
+
+bool shim_cfg::validate_config() {
+  static const char *s_lists[enum_n_levels] = { "sites", "buildings", "aps" };
+  reset_error();
+  m_errors.clear();
+
+  // decoder tables of each level, the objects are only created for their meta
+  const decoder_table *dt[enum_n_levels];
+  bool deferred = object_config::is_id_deferred();
+  object_config::is_id_deferred() = true;
+  for (int i = 0; i < enum_n_levels; ++i) {
+    meta_map *mm = nullptr;
+    create_object(s_lists[i], mm);
+    dt[i] = &get_decoders(*mm);
+  }
+  object_config::is_id_deferred() = deferred;
+
+  if (m_mapped) {
+    int sites = m_tree->child(0, s_lists[0]);
+    if (sites < 0)
+      m_errors.push_back(string(s_lists[0]) + ": not found");
+    else
+      validate(*m_tree, sites, 0, dt);
+  }
+  else {
+    const settings &root = getRoot();
+    if (!root.exists(s_lists[0]))
+      m_errors.push_back(string(s_lists[0]) + ": not found");
+    else
+      validate(root[s_lists[0]], 0, dt);
+  }
+
+  if (m_errors.empty())
+    return true;
+  m_error = to_string(m_errors.size()) + " errors found, first " + m_errors.front();
+  return false;
+}
+
+// records of the list node at level and their child lists
+void shim_cfg::validate(const settings &node, int level,
+                        const decoder_table **dt) {
+  static const char *s_lists[enum_n_levels] = { "sites", "buildings", "aps" };
+  if (!node.isList() && !node.isArray()) {
+    m_errors.push_back(node.getPath() + ": " + type_mismatch(enum_cfg_list));
+    return;
+  }
+  for (const auto &n : node) {
+    if (!n.isGroup()) {
+      m_errors.push_back(n.getPath() + ": " + type_mismatch(enum_cfg_group));
+      continue;
+    }
+    validate_record(n, *dt[level]);
+    if (level + 1 == enum_n_levels)
+      continue;
+    const char *child_list = s_lists[level + 1];
+    if (n.exists(child_list))
+      validate(n[child_list], level + 1, dt);
+    else
+      m_errors.push_back(n.getPath() + ": " + child_list + " not found");
+  }
+}
+
+void shim_cfg::validate(const cfg_tree &tr, int node, int level,
+                        const decoder_table **dt) {
+  static const char *s_lists[enum_n_levels] = { "sites", "buildings", "aps" };
+  cfg_type_t type = tr.at(node).m_type;
+  if (type != enum_cfg_list && type != enum_cfg_array) {
+    m_errors.push_back(tr.get_path(node) + ": " + type_mismatch(enum_cfg_list));
+    return;
+  }
+  for (int n = tr.at(node).m_first_child; n >= 0; n = tr.at(n).m_next_sibling) {
+    if (tr.at(n).m_type != enum_cfg_group) {
+      m_errors.push_back(tr.get_path(n) + ": " + type_mismatch(enum_cfg_group));
+      continue;
+    }
+    validate_record(tr, n, *dt[level]);
+    if (level + 1 == enum_n_levels)
+      continue;
+    const char *child_list = s_lists[level + 1];
+    int c = tr.child(n, child_list);
+    if (c >= 0)
+      validate(tr, c, level + 1, dt);
+    else
+      m_errors.push_back(tr.get_path(n) + ": " + child_list + " not found");
+  }
+}
+
+// same checks as the decoders, the path is only formatted for an error
+void shim_cfg::validate_record(const settings &n, const decoder_table &dt) {
+  for (const auto &d : dt) {
+    cfg_type_t want = expected_type(d.m_meta->m_vtype);
+    if (want == enum_cfg_none)
+      continue;
+    const settings *s = resolve(n, d.m_path);
+    if (!s) {
+      if (d.m_groups || d.m_meta->m_trait == enum_var_required)
+        m_errors.push_back(n.getPath() + ": " + *d.m_var + " is required");
+      continue;
+    }
+    if (!is_list_type(d.m_meta->m_vtype)) {
+      if ((cfg_type_t)s->getType() != want)
+        m_errors.push_back(s->getPath() + ": " + type_mismatch(want));
+      continue;
+    }
+    if (!s->isList() && !s->isArray()) {
+      m_errors.push_back(s->getPath() + ": " + type_mismatch(enum_cfg_list));
+      continue;
+    }
+    for (int i = 0; i < s->getLength(); ++i) {
+      const settings *e = (d.m_groups ? resolve((*s)[i], d.m_element) : &(*s)[i]);
+      if (!e)
+        m_errors.push_back(n.getPath() + ": "
+                           + element_path(d.m_meta->m_node, i) + " is required");
+      else if ((cfg_type_t)e->getType() != want)
+        m_errors.push_back(e->getPath() + ": " + type_mismatch(want));
+      else if (d.m_meta->m_vtype == enum_type_channel_set
+               && !channel_set::is_channel((int)*e))
+        m_errors.push_back(e->getPath() + ": "
+                           + channel_set::not_channel((int)*e));
+    }
+  }
+}
+
+void shim_cfg::validate_record(const cfg_tree &tr, int n,
+                               const decoder_table &dt) {
+  for (const auto &d : dt) {
+    cfg_type_t want = expected_type(d.m_meta->m_vtype);
+    if (want == enum_cfg_none)
+      continue;
+    int s = resolve(tr, n, d.m_path);
+    if (s < 0) {
+      if (d.m_groups || d.m_meta->m_trait == enum_var_required)
+        m_errors.push_back(tr.get_path(n) + ": " + *d.m_var + " is required");
+      continue;
+    }
+    cfg_type_t type = tr.at(s).m_type;
+    if (!is_list_type(d.m_meta->m_vtype)) {
+      if (type != want)
+        m_errors.push_back(tr.get_path(s) + ": " + type_mismatch(want));
+      continue;
+    }
+    if (type != enum_cfg_list && type != enum_cfg_array) {
+      m_errors.push_back(tr.get_path(s) + ": " + type_mismatch(enum_cfg_list));
+      continue;
+    }
+    int i = 0;
+    for (int c = tr.at(s).m_first_child; c >= 0; c = tr.at(c).m_next_sibling, ++i) {
+      int e = (d.m_groups ? resolve(tr, c, d.m_element) : c);
+      if (e < 0)
+        m_errors.push_back(tr.get_path(n) + ": "
+                           + element_path(d.m_meta->m_node, i) + " is required");
+      else if (tr.at(e).m_type != want)
+        m_errors.push_back(tr.get_path(e) + ": " + type_mismatch(want));
+      else if (d.m_meta->m_vtype == enum_type_channel_set) {
+        int ch = 0;
+        tr.get(e, ch);
+        if (!channel_set::is_channel(ch))
+          m_errors.push_back(tr.get_path(e) + ": " + channel_set::not_channel(ch));
+      }
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// shim_cfg::lazy_record
+// record of object in the mapped tree, decodes one member on first access
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class shim_cfg::lazy_record : public lazy_source {
+public:
+  lazy_record(const shared_ptr<cfg_tree> &tr, int n, const decoder_table &dt)
+      : m_tree(tr), m_node(n), m_decoders(dt) {}
+
+  virtual void materialize(const meta_t &m, const member_t &b) {
+    // decoders are built in the order of meta map, i.e. indexed by field id
+    const field_decoder &d = m_decoders[m.m_field];
+    d.m_decode_tree(*m_tree, m_node, d, b);
+  }
+
+private:
+  shared_ptr<cfg_tree> m_tree;
+  int m_node;
+  const decoder_table &m_decoders;
+
+}; // class shim_cfg::lazy_record
+
+// presence of required members, checked at load time in lazy mode so that
+// first access does not fail on a missing member
+void shim_cfg::check_required(const cfg_tree &tr, int n,
+                              const decoder_table &dt) {
+  for (const auto &d : dt)
+    if (d.m_meta->m_trait == enum_var_required && resolve(tr, n, d.m_path) < 0)
+      throw runtime_error(*d.m_var + " is required");
+}
+
+// channels of channel sets, checked at load time in lazy mode for the same
+// reason, an int element outside of the cbrs channels fails decoding
+void shim_cfg::check_range(const cfg_tree &tr, int n, const decoder_table &dt) {
+  for (const auto &d : dt) {
+    if (d.m_meta->m_vtype != enum_type_channel_set)
+      continue;
+    int s = resolve(tr, n, d.m_path);
+    if (s < 0)
+      continue;
+    for (int c = tr.at(s).m_first_child; c >= 0; c = tr.at(c).m_next_sibling) {
+      int e = (d.m_groups ? resolve(tr, c, d.m_element) : c);
+      if (e < 0 || tr.at(e).m_type != enum_cfg_int)
+        continue;
+      int ch = 0;
+      tr.get(e, ch);
+      if (!channel_set::is_channel(ch))
+        throw runtime_error(tr.get_path(e) + ", " + channel_set::not_channel(ch));
+    }
+  }
+}
+
+// hash of node and its descendants except the child skip
+uint64_t shim_cfg::hash_node(int n, uint64_t h, int skip) const {
+  const cfg_tree::node &e = m_tree->at(n);
+  uint32_t head[3] = { (uint32_t)e.m_type, (uint32_t)e.m_name.size(),
+                       (uint32_t)e.m_text.size() };
+  h = util_hash_fnv1a(head, sizeof(head), h);
+  h = util_hash_fnv1a(e.m_name.data(), e.m_name.size(), h);
+  h = util_hash_fnv1a(e.m_text.data(), e.m_text.size(), h);
+  for (int c = e.m_first_child; c >= 0; c = m_tree->at(c).m_next_sibling)
+    if (c != skip)
+      h = hash_node(c, h, -1);
+  return h;
+}
+
+// hash each record under the list node once into m_hashes, the hash of a
+// subtree combines the record hash with the subtree hashes of its children.
+// Parent names are folded into the seed since they are decoded into composed
+// fields
+uint64_t shim_cfg::hash_records(int list, int level, const string &site,
+                                const string &building) {
+  static const char *s_lists[enum_n_levels] = { "buildings", "aps", nullptr };
+  uint64_t seed = util_hash_fnv1a(site.data(), site.size() + 1);
+  seed = util_hash_fnv1a(building.data(), building.size() + 1, seed);
+  uint64_t h = seed;
+  for (int n = m_tree->at(list).m_first_child; n >= 0;
+       n = m_tree->at(n).m_next_sibling) {
+    int c = (s_lists[level] ? m_tree->child(n, s_lists[level]) : -1);
+    hash_t &rh = m_hashes[n];
+    rh.first = hash_node(n, seed, c);
+    rh.second = rh.first;
+    if (c >= 0) {
+      string name = record_key(level, n);
+      uint64_t ch = (level == 0 ? hash_records(c, 1, name, string())
+                                : hash_records(c, 2, site, name));
+      rh.second = util_hash_fnv1a(&ch, sizeof(ch), rh.first);
+    }
+    h = util_hash_fnv1a(&rh.second, sizeof(rh.second), h);
+  }
+  return h;
+}
+
+// shim key of record read from the tree without decoding, empty if missing
+string shim_cfg::record_key(int level, int n) const {
+  if (level < 2) {
+    int c = m_tree->child(n, "name");
+    return c < 0 ? string() : string(m_tree->at(c).m_text);
+  }
+  int f = m_tree->child(n, "fcc_id");
+  int s = m_tree->child(n, "serial_number");
+  if (f < 0 || s < 0)
+    return string();
+  return string(m_tree->at(f).m_text) + ":" + string(m_tree->at(s).m_text);
+}
+
+// move the hashes of an unchanged record and its descendants from prev to
+// next
+void shim_cfg::keep_loaded(int level, const string &key, loaded_map *prev,
+                           loaded_map *next) {
+  auto nh = prev[level].extract(key);
+  if (nh.empty())
+    return;
+  if (level + 1 < enum_n_levels)
+    for (const auto &k : nh.mapped().m_children)
+      keep_loaded(level + 1, k, prev, next);
+  next[level].insert(std::move(nh));
+}
+
+// same as traverse, on the tree loaded by map_config, the parent names are
+// passed down instead of looked up by path. Hashes of each record, with and
+// without its child list, are kept in next. With the hashes of previous load
+// in prev, unchanged records keep their objects and are not decoded. The
+// entry of a record leaves prev only once its hashes are in next, so that
+// prev and next together always cover the records in shim
+void shim_cfg::traverse_tree(int node, const string &site,
+                             const string &building, loaded_map *prev,
+                             loaded_map *next, vector<string> *keys,
+                             vector<object_config_ptr> *objs /* = nullptr */) {
+  static const char *s_lists[enum_n_levels] = { "sites", "buildings", "aps" };
+  string node_name(m_tree->at(node).m_name);
+  int level = 0;
+  while (level < enum_n_levels && node_name != s_lists[level])
+    ++level;
+  if (level == enum_n_levels)
+    return;
+  for (int n = m_tree->at(node).m_first_child; n >= 0;
+       n = m_tree->at(n).m_next_sibling)
+    traverse_record(level, n, site, building, prev, next, keys, objs);
+}
+
+// one record of traverse_tree and the records below it, objects are collected
+// into objs if given instead of inserted into shim
+void shim_cfg::traverse_record(int level, int n, const string &site,
+                               const string &building, loaded_map *prev,
+                               loaded_map *next, vector<string> *keys,
+                               vector<object_config_ptr> *objs) {
+  static const char *s_lists[enum_n_levels] = { "sites", "buildings", "aps" };
+  const char *child_list = (level + 1 < enum_n_levels ? s_lists[level + 1] : nullptr);
+  int c = (child_list ? m_tree->child(n, child_list) : -1);
+  if (child_list && c < 0)
+    throw runtime_error(m_tree->get_path(n) + "." + child_list + " not found");
+  loaded_t lh;
+  // at, not operator[], workers of traverse_tree_parallel share the map
+  const hash_t &rh = m_hashes.at(n);
+  lh.m_record = rh.first;
+  lh.m_subtree = rh.second;
+
+  // unchanged subtree, or unchanged record with changes below
+  string key = (prev ? record_key(level, n) : string());
+  object_config_ptr oc = nullptr;
+  if (!key.empty()) {
+    auto it = prev[level].find(key);
+    if (it != prev[level].end() && it->second.m_subtree == lh.m_subtree) {
+      keep_loaded(level, key, prev, next);
+      if (keys)
+        keys->push_back(key);
+      return;
+    }
+    if (it != prev[level].end() && it->second.m_record == lh.m_record)
+      oc = shim::instance().find_config(key);
+  }
+
+  if (!oc) {
+    meta_map *mm = nullptr;
+    oc = create_object(s_lists[level], mm);
+    const decoder_table &dt = get_decoders(*mm);
+    if (m_lazy && level == 2) {
+      check_required(*m_tree, n, dt);
+      check_range(*m_tree, n, dt);
+      oc->set_lazy(make_shared<lazy_record>(m_tree, n, dt));
+    }
+    else
+      for (const auto &d : dt)
+        d.m_decode_tree(*m_tree, n, d, oc->get_member(*d.m_meta));
+    if (level == 1) {
+      building_config_ptr tc = std::dynamic_pointer_cast<building_config>(oc);
+      tc->set_site_name(site);
+    }
+    else if (level == 2) {
+      ap_config_ptr cc = std::dynamic_pointer_cast<ap_config>(oc);
+      cc->set_site_name(site);
+      cc->set_building_name(building);
+      cc->set_name(cc->get_fcc_id() + ":" + cc->get_serial_number());
+    }
+    commit_object(oc, objs);
+    key = oc->get_key();
+  }
+  if (keys)
+    keys->push_back(key);
+
+  if (level == 0) {
+    site_config_ptr dc = std::dynamic_pointer_cast<site_config>(oc);
+    traverse_tree(c, dc->get_name(), string(), prev, next, &lh.m_children, objs);
+  }
+  else if (level == 1) {
+    building_config_ptr tc = std::dynamic_pointer_cast<building_config>(oc);
+    traverse_tree(c, site, tc->get_name(), prev, next, &lh.m_children, objs);
+  }
+  if (prev)
+    prev[level].erase(key);
+  next[level][key] = std::move(lh);
+}
+
+// traverse_tree of a first load on worker threads, same as traverse_parallel,
+// each site record is decoded with ids deferred into objects and hashes of its
+// own, then ids are assigned and both kept in the order of sites
+void shim_cfg::traverse_tree_parallel(int sites) {
+  vector<int> nodes;
+  for (int n = m_tree->at(sites).m_first_child; n >= 0;
+       n = m_tree->at(n).m_next_sibling)
+    nodes.push_back(n);
+  int n_sites = (int)nodes.size();
+  if (n_sites == 0)
+    return;
+  vector<vector<object_config_ptr>> objs(n_sites);
+  vector<loaded_map> loaded(n_sites * enum_n_levels);
+  vector<exception_ptr> errors(n_sites);
+  atomic<int> next(0);
+
+  prepare_decoders();
+  auto worker = [&]() {
+    object_config::is_id_deferred() = true;
+    for (int i = next++; i < n_sites; i = next++) {
+      try {
+        traverse_record(0, nodes[i], string(), string(), nullptr,
+                        &loaded[i * enum_n_levels], nullptr, &objs[i]);
+      } catch (...) {
+        errors[i] = current_exception();
+      }
+    }
+  };
+
+  vector<thread> workers;
+  unsigned n_workers = min(m_n_threads, (unsigned)n_sites);
+  for (unsigned i = 0; i < n_workers; ++i)
+    workers.emplace_back(worker);
+  for (auto &w : workers)
+    w.join();
+
+  shim &sh = shim::instance();
+  for (int i = 0; i < n_sites; ++i) {
+    if (errors[i])
+      rethrow_exception(errors[i]);
+    for (const auto &oc : objs[i]) {
+      oc->assign_id();
+      sh.insert_config(oc);
+    }
+    // a later record of the same key wins, as in the serial traverse
+    for (int l = 0; l < enum_n_levels; ++l)
+      for (auto &e : loaded[i * enum_n_levels + l])
+        m_loaded[l][e.first] = std::move(e.second);
+  }
+}
+
+// a failed reload is not rolled back nor published, records decoded before
+// the failure stay in shim and none is deleted. m_loaded then holds the previous hashes of the
+// other records, so that the next reload decodes them again and deletes the
+// records removed from the file
+bool shim_cfg::reload_config(const string &fn) {
+  if (!map_config(fn))
+    return false;
+
+  loaded_map prev[enum_n_levels], next[enum_n_levels];
+  for (int i = 0; i < enum_n_levels; ++i)
+    prev[i].swap(m_loaded[i]);
+  try {
+    cout << "ver = " << m_ver << endl;
+    int sites = m_tree->child(0, "sites");
+    if (sites < 0)
+      throw runtime_error("sites not found");
+    m_hashes.clear();
+    hash_records(sites, 0, string(), string());
+    traverse_tree(sites, string(), string(), prev, next, nullptr);
+
+    // records left in prev are no longer in the file
+    shim &sh = shim::instance();
+    for (int i = enum_n_levels - 1; i >= 0; --i)
+      for (const auto &p : prev[i])
+        sh.delete_config(p.first);
+    sh.publish();
+    for (int i = 0; i < enum_n_levels; ++i)
+      m_loaded[i].swap(next[i]);
+    return true;
+  } catch (const exception &e) {
+    // records applied so far keep their new hashes
+    for (int i = 0; i < enum_n_levels; ++i) {
+      prev[i].merge(next[i]);
+      m_loaded[i].swap(prev[i]);
+    }
+    ostringstream oss;
+    oss << "exception occurred during reloading settings, " << e.what();
+    m_error = oss.str();
+    return false;
   }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// shim_cfg::stream_handler
+// receiver of cfg_reader events, collects one record of site, building or ap
+// at a time and inserts it into shim once complete
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class shim_cfg::stream_handler : public cfg_handler {
+public:
+  stream_handler(shim_cfg &c) : m_cfg(c) {
+    frame f = { enum_frame_root, -1, -1, false };
+    m_frames.push_back(f);
+  }
+
+  virtual void on_begin(string_view name, cfg_type_t type) {
+    frame &f = m_frames.back();
+    frame next = { enum_frame_skip, f.m_level, -1, false };
+    bool aggregate_list = (type == enum_cfg_list || type == enum_cfg_array);
+    switch (f.m_type) {
+      case enum_frame_root:
+        if (name == s_lists[0] && aggregate_list) {
+          next.m_type = enum_frame_records;
+          next.m_level = 0;
+        }
+        break;
+      case enum_frame_records:
+        if (type == enum_cfg_group) {
+          m_record.clear();
+          next.m_type = enum_frame_record;
+          next.m_node = 0;
+        }
+        break;
+      case enum_frame_record:
+        if (f.m_level + 1 < enum_n_levels && name == s_lists[f.m_level + 1]
+            && aggregate_list) {
+          if (!f.m_done)
+            emit();
+          next.m_type = enum_frame_records;
+          next.m_level = f.m_level + 1;
+          break;
+        }
+        check_pending(f, name);
+        next.m_type = enum_frame_content;
+        next.m_node = m_record.add(f.m_node, type, name, string_view());
+        break;
+      case enum_frame_content:
+        next.m_type = enum_frame_content;
+        next.m_node = m_record.add(f.m_node, type, name, string_view());
+        break;
+      default:
+        break;
+    }
+    m_frames.push_back(next);
+  }
+
+  virtual void on_end(cfg_type_t) {
+    frame f = m_frames.back();
+    m_frames.pop_back();
+    if (f.m_type == enum_frame_record && !f.m_done) {
+      m_frames.push_back(f);
+      emit();
+      m_frames.pop_back();
+    }
+  }
+
+  virtual void on_value(string_view name, cfg_type_t type, string_view text) {
+    frame &f = m_frames.back();
+    if (f.m_type == enum_frame_root) {
+      if (name == "ver")
+        m_cfg.m_ver = atoi(string(text).c_str());
+    }
+    else if (f.m_type == enum_frame_record) {
+      check_pending(f, name);
+      m_record.add(f.m_node, type, name, text);
+    }
+    else if (f.m_type == enum_frame_content)
+      m_record.add(f.m_node, type, name, text);
+  }
+
+private:
+  enum frame_t {
+    enum_frame_root,
+    enum_frame_records,
+    enum_frame_record,
+    enum_frame_content,
+    enum_frame_skip
+  };
+  enum { enum_n_levels = 3 };
+
+  struct frame {
+    frame_t m_type;
+    int m_level;
+    int m_node;
+    bool m_done;
+  };
+
+  // record was emitted when its child list began, no more members allowed
+  void check_pending(const frame &f, string_view name) {
+    if (f.m_done)
+      throw runtime_error(string(name) + " follows " + s_lists[f.m_level + 1]
+                          + ", not supported by streaming load");
+  }
+
+  // decode the record on top of stack and insert it into shim
+  void emit() {
+    frame &f = m_frames.back();
+    f.m_done = true;
+
+    meta_map *mm = nullptr;
+    object_config_ptr oc = m_cfg.create_object(s_lists[f.m_level], mm);
+    for (const auto &d : get_decoders(*mm))
+      d.m_decode_tree(m_record, 0, d, oc->get_member(*d.m_meta));
+
+    // handle composed fields of parent names and ap name
+    if (f.m_level == 0) {
+      site_config_ptr dc = std::dynamic_pointer_cast<site_config>(oc);
+      m_site = dc->get_name();
+    }
+    else if (f.m_level == 1) {
+      building_config_ptr tc = std::dynamic_pointer_cast<building_config>(oc);
+      tc->set_site_name(m_site);
+      m_building = tc->get_name();
+    }
+    else {
+      ap_config_ptr cc = std::dynamic_pointer_cast<ap_config>(oc);
+      cc->set_site_name(m_site);
+      cc->set_building_name(m_building);
+      cc->set_name(cc->get_fcc_id() + ":" + cc->get_serial_number());
+    }
+    shim::instance().insert_config(oc);
+  }
+
+  static const char *s_lists[enum_n_levels];
+
+  shim_cfg &m_cfg;
+  vector<frame> m_frames;
+  cfg_tree m_record;
+  string m_site;
+  string m_building;
+
+}; // class shim_cfg::stream_handler
+
+const char *shim_cfg::stream_handler::s_lists[] = { "sites", "buildings", "aps" };
+
+bool shim_cfg::stream_config(const string &fn) {
+  try {
+    m_ifn = fn;
+    reset_error();
+
+    cfg_reader r;
+    r.set_include_dir(util_extract_path(fn));
+    stream_handler h(*this);
+    r.read_file(fn, h);
+    shim::instance().publish();
+    return true;
+  } catch (const cfg_parse_error &ep) {
+    ostringstream oss;
+    oss << "failed to parse config file at " << ep.get_file() << ":"
+        << ep.get_line() << ", " << ep.what();
+    m_error = oss.str();
+    return false;
+  } catch (const exception &e) {
+    ostringstream oss;
+    oss << "exception occurred during streaming settings, " << e.what();
+    m_error = oss.str();
+    return false;
+  }
+}
+
+bool shim_cfg::map_config(const string &fn) {
+  try {
+    m_ifn = fn;
+    m_mapped = false;
+    reset_error();
+
+    cfg_reader r;
+    r.set_include_dir(util_extract_path(fn));
+    r.set_mapped(true);
+    r.set_shards(m_n_threads);
+    // objects in lazy mode may still refer to the previous tree
+    if (m_tree.use_count() == 1)
+      m_tree->clear();
+    else
+      m_tree = make_shared<cfg_tree>();
+    cfg_tree_builder h(*m_tree);
+    m_shard_stats.clear();
+    r.read_file(fn, h);
+    m_shard_stats = r.get_shard_stats();
+
+    int v = m_tree->child(0, "ver");
+    if (v >= 0)
+      m_tree->get(v, m_ver);
+    m_mapped = true;
+    return true;
+  } catch (const cfg_parse_error &ep) {
+    ostringstream oss;
+    oss << "failed to parse config file at " << ep.get_file() << ":"
+        << ep.get_line() << ", " << ep.what();
+    m_error = oss.str();
+    return false;
+  } catch (const exception &e) {
+    ostringstream oss;
+    oss << "failed to load config file " << m_ifn << ", " << e.what();
+    m_error = oss.str();
+    return false;
+  }
+}
+
+// hash of the file content followed by the files it includes, in order,
+// 0 if a file can not be read. Includes are found by the tokenizer and
+// resolved against the directory of fn, the include dir of load_config
+uint64_t shim_cfg::hash_config(const string &fn) {
+  shared_ptr<cfg_mapping> m = cfg_mapping::open(fn);
+  if (!m)
+    return 0;
+  uint64_t h = util_hash_fnv1a(m->data(), m->size());
+
+  vector<string> incs;
+  try {
+    cfg_reader r;
+    r.set_include_dir(util_extract_path(fn));
+    incs = r.get_includes(fn);
+  } catch (const exception &) {
+    return 0;
+  }
+  for (const auto &inc : incs) {
+    shared_ptr<cfg_mapping> mi = cfg_mapping::open(inc);
+    if (!mi)
+      return 0;
+    uint64_t hi = util_hash_fnv1a(mi->data(), mi->size());
+    h = util_hash_fnv1a(&hi, sizeof(hi), h);
+  }
+  return h;
+}
+
+bool shim_cfg::cache_config(const string &fn) {
+  string snap = fn + ".snap";
+  uint64_t h = hash_config(fn);
+  m_ifn = fn;
+  reset_error();
+  if (h != 0 && shim::instance().load_snapshot(snap, h, m_ver)) {
+    shim::instance().publish();
+    return true;
+  }
+
+  if (!load_config(fn) || !parse_config())
+    return false;
+  if (h != 0 && !shim::instance().save_snapshot(snap, h, m_ver))
+    cerr << "failed to write snapshot " << snap << endl;
+  return true;
+}
+
 object_config_ptr shim_cfg::duplicate(const object_config_ptr &s, int dst_ver) {
   object_config_ptr d = nullptr;
   try {
@@ -1243,8 +2201,8 @@ bool shim_cfg::migrate_config(int dst_ver) {
 
   try {
     shim &sh = shim::instance();
+    // copy, each object is deleted and inserted again at the end
     vector<object_config_ptr> ordered_oc = sh.get_ordered_oc();
-    sh.clear_ordered_oc();
     for (const auto &s : ordered_oc) {
       // step 1: duplicate
       object_config_ptr d = duplicate(s, dst_ver);
@@ -1295,15 +2253,15 @@ bool shim_cfg::migrate_config(int dst_ver) {
 
       // in compile time, use the macro, based on the type, create get and set corresponding with different settings
       // in run time, create new object and call init, bring up the meta data that already builded in compile time
+      // one value is reused for all members, it is moved into d
+      var_value v;
       for (auto vu : unchanged) {
-        std::any v;
         if (s->get(vu, v))
-          d->set(vu, v);
+          d->set(vu, std::move(v));
       }
       for (auto vc : changed) {
-        std::any v;
         if (s->get(vc, v))
-          d->set(vc, v);
+          d->set(vc, std::move(v));
       }
 
       // step 4: insert new config to shim store and remove original
@@ -1317,6 +2275,7 @@ bool shim_cfg::migrate_config(int dst_ver) {
 
     }
 
+    sh.publish();
     return true;
   }
   catch (const exception &e)
@@ -1326,178 +2285,113 @@ bool shim_cfg::migrate_config(int dst_ver) {
   }
 }
 
+// writes one member into the output group, the value is borrowed from the
+// object. False for values with no setting, e.g. obj_id
+struct emit_visitor {
+  settings &op;
+  const string &name;
+
+  bool operator()(monostate) { return false; }
+  bool operator()(const uint64_t *) { return false; }
+  bool operator()(const int *v) {
+    op.add(name, settings::TypeInt) = *v;
+    return true;
+  }
+  bool operator()(const unsigned *v) {
+    op.add(name, settings::TypeInt) = static_cast<int>(*v);
+    return true;
+  }
+  bool operator()(const long *v) {
+    op.add(name, settings::TypeInt64) = *v;
+    return true;
+  }
+  bool operator()(const double *v) {
+    op.add(name, settings::TypeFloat) = *v;
+    return true;
+  }
+  bool operator()(const string *v) {
+    op.add(name, settings::TypeString) = *v;
+    return true;
+  }
+  bool operator()(const bool *v) {
+    op.add(name, settings::TypeBoolean) = *v;
+    return true;
+  }
+  bool operator()(const list<int> *v) { return ints(*v); }
+  bool operator()(const channel_set *v) { return ints(*v); }
+  bool operator()(const list<string> *v) { return strings(*v); }
+  bool operator()(const string_vector *v) { return strings(*v); }
+
+  template <typename C> bool ints(const C &vs) {
+    settings &temp = op.add(name, settings::TypeArray);
+    for (int i : vs)
+      temp.add(settings::TypeInt) = i;
+    return true;
+  }
+  template <typename C> bool strings(const C &vs) {
+    settings &temp = op.add(name, settings::TypeArray);
+    for (const auto &i : vs)
+      temp.add(settings::TypeString) = i;
+    return true;
+  }
+};
+
+// write members of o into group op of the output cfg
+void shim_cfg::build_object(const object_config_ptr &o, settings *op) {
+  o->materialize_all();
+  meta_map *mm = &(o->get_meta_info());
+  for (auto &b : *mm) {
+    // borrowed, members are not copied on the way out
+    member_t mb = o->get_member(b.second);
+    var_cref v = mb.m_xetter->ref(mb.m_var);
+    if (std::visit(emit_visitor{ *op, b.first }, v))
+      continue;
+    list<string> added = get_added();
+    for (auto &a : added) {
+      meta_t ad = (*mm)[a];
+      switch (ad.m_vtype) {
+        case enum_type_int: (*op).add(a, settings::TypeInt); break;
+        case enum_type_long: (*op).add(a, settings::TypeInt64); break;
+        case enum_type_double: (*op).add(a, settings::TypeFloat); break;
+        case enum_type_string:
+        case enum_type_istring: (*op).add(a, settings::TypeString); break;
+        case enum_type_bool: (*op).add(a, settings::TypeBoolean); break;
+        case enum_type_list_int:
+        case enum_type_list_string:
+        case enum_type_channel_set:
+        case enum_type_string_vector: (*op).add(a, settings::TypeArray); break;
+        default: break;
+      }
+    }
+  }
+}
+
+// sites in insertion order, each followed by its buildings and their aps from
+// the hierarchy in shim
 void shim_cfg::build_traverse(shim &sh) {
   try {
     reset_result_cfg();
     settings &root = result_cfg.getRoot();
     root.add("ver", settings::TypeInt) = m_ver;
-    vector<object_config_ptr> ordered_oc = sh.get_ordered_oc();
-    for (auto &o : ordered_oc) {
-      member_map *bm = &(o->get_members());
-      meta_map *mm = &(o->get_meta_info());
-      settings *op = nullptr;
-
-      if(object_config::is_site(o->get_map_id())){
-        if (!root.exists("sites"))
-          root.add("sites", settings::TypeList);
-        settings &dc = root.lookup("sites");
-        settings &ds = dc.add(settings::TypeGroup);
-        // locate site in output cfg file
-        op = &ds;
-      }
-      else if (object_config::is_building(o->get_map_id())) {
-        std::any v;
-        (*bm)["site_name"].m_xetter->get((*bm)["site_name"].m_var, v);
-        string dc_name = any_cast<string>(v);
-        settings &dc = root["sites"];
-        int count_dc = 0;
-        for (auto &d : dc) {
-          const char *name = static_cast<const char *>(d.lookup("name"));
-          if (name == dc_name)
-            break;
-          count_dc++;
-        }
-        settings &ds = dc[count_dc];
+    for (const auto &o : sh.ordered_view()) {
+      if (!object_config::is_site(o->get_map_id()))
+        continue;
+      if (!root.exists("sites"))
+        root.add("sites", settings::TypeList);
+      settings &ds = root["sites"].add(settings::TypeGroup);
+      build_object(o, &ds);
+
+      for (const auto &t : sh.find_children(o->get_key())) {
         if (!ds.exists("buildings"))
           ds.add("buildings", Setting::TypeList);
-        settings &tc = ds["buildings"];
-        settings &ts = tc.add(settings::TypeGroup);
-        // locate building in output cfg file
-        op = &ts;
-      }
-      else if (object_config::is_ap(o->get_map_id())) {
-        std::any v_1, v_2;
-        (*bm)["site_name"].m_xetter->get((*bm)["site_name"].m_var, v_1);
-        (*bm)["building_name"].m_xetter->get((*bm)["building_name"].m_var, v_2);
-        string dc_name = any_cast<string>(v_1);
-        string tc_name = any_cast<string>(v_2);
-        settings &dc = root["sites"];
-        int count_ds = 0;
-        int count_ts = 0;
-        for (auto &d : dc) {
-          const char *name = static_cast<const char *>(d.lookup("name"));
-          if (name == dc_name)
-            break;
-          count_ds++;
-        }
-        settings &ds = dc[count_ds];
-        settings &tc = ds["buildings"];
-        for (auto &t : tc) {
-          const char *name = static_cast<const char *>(t.lookup("name"));
-          if (name == tc_name)
-            break;
-          count_ts++;
-        }
-        settings &ts = tc[count_ts];
-        if (!ts.exists("aps"))
-          ts.add("aps", Setting::TypeList);
-        settings &cc = ts["aps"];
-        settings &cs = cc.add(settings::TypeGroup);
-        // locate ap in output cfg
-        op = &cs;
-      }
-      
-
-      for (auto &b : *bm) {
-        std::any v;
-        b.second.m_xetter->get(b.second.m_var, v);
-        meta_t m = (*mm)[b.first];
-        if (m.m_type == "int" || m.m_type == "int32_t") {
-          if (v.type() == typeid(int)) {
-            int val = any_cast<int>(v);
-            (*op).add(b.first, settings::TypeInt) = val;
-          }
-          else
-            throw runtime_error("unexpected type" + b.first);
-        }
-        else if (m.m_type == "unsigned") {
-          if (v.type() == typeid(unsigned)) {
-            unsigned int val = any_cast<unsigned int>(v);
-            (*op).add(b.first, settings::TypeInt) = static_cast<int>(val);
-          }
-          else 
-            throw runtime_error("unexpected type" + b.first);
-        }
-        else if (m.m_type == "long") {
-          if (v.type() == typeid(long)) {
-            long val = any_cast<long>(v);
-            (*op).add(b.first, settings::TypeInt64) = val;
-          }
-          else 
-            throw runtime_error("unexpected type" + b.first);
-        }
-        else if (m.m_type == "float") {
-          if (v.type() == typeid(float)) {
-            float val = any_cast<float>(v);
-            (*op).add(b.first, settings::TypeFloat) = val;
-          }
-          else
-            throw runtime_error("unexpected type" + b.first);
-        }
-        else if (m.m_type == "double") {
-          if (v.type() == typeid(double)) {
-            double val = any_cast<double>(v);
-            (*op).add(b.first, settings::TypeFloat) = val;
-          }
-          else 
-            throw runtime_error("unexpected type" + b.first);
-        }
-        else if (m.m_type == "string") {
-          if (v.type() == typeid(string)) {
-            string val = any_cast<string>(v);
-            (*op).add(b.first, settings::TypeString) = val;
-          }
-          else 
-            throw runtime_error("unexpected type" + b.first);
-        }
-        else if (m.m_type == "bool") {
-          if (v.type() == typeid(bool)) {
-            bool val = any_cast<bool>(v);
-            (*op).add(b.first, settings::TypeBoolean) = val;
-          }
-          else 
-            throw runtime_error("unexpected type" + b.first);
-        }
-        else if (m.m_type == "list<int>") {
-          if (v.type() == typeid(list<int>)) {
-            list<int> val = any_cast<list<int>>(v);
-            settings &temp = (*op).add(b.first, settings::TypeArray);
-            for (auto i : val) {
-              temp.add(settings::TypeInt) = i;
-            }
-          }
-          else 
-            throw runtime_error("unexpected type" + b.first);
-        }
-        else if (m.m_type == "list<string>") {
-          if (v.type() == typeid(list<string>)) {
-            list<string> val = any_cast<list<string>>(v);
-            settings &temp = (*op).add(b.first, settings::TypeArray);
-            for (auto i : val) {
-              temp.add(settings::TypeString) = i;
-            }
-          }
-          else 
-            throw runtime_error("unexpected type" + b.first);
-        }
-        else {
-          list<string> added = get_added();
-          for (auto &a : added) {
-            meta_t ad = (*mm)[a];
-            string type = ad.m_type;
-            if (type == "int" || type == "int32_t")
-              (*op).add(a, settings::TypeInt);
-            else if (type == "long")
-              (*op).add(a, settings::TypeInt64);
-            else if (type == "float" || type == "double")
-              (*op).add(a, settings::TypeFloat);
-            else if (type == "string")
-              (*op).add(a, settings::TypeString);
-            else if (type == "bool")
-              (*op).add(a, settings::TypeBoolean);
-            else if (type == "list<int>" || type == "list<string>")
-              (*op).add(a, settings::TypeArray);
-          }
+        settings &ts = ds["buildings"].add(settings::TypeGroup);
+        build_object(t, &ts);
+
+        for (const auto &c : sh.find_children(t->get_key())) {
+          if (!ts.exists("aps"))
+            ts.add("aps", Setting::TypeList);
+          settings &cs = ts["aps"].add(settings::TypeGroup);
+          build_object(c, &cs);
         }
       }
     }
@@ -5,10 +5,12 @@
 #include <string>
 // #include <variant>
 // #include <map>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <libconfig.h++>
 
+#include "reader.h"
 #include "shim.h"
 
 using namespace libconfig;
@@ -149,8 +151,48 @@ class shim_cfg : public configurator
 public:
   virtual bool parse_config();
   bool migrate_config(int);
+
+  // check the file loaded by load_config or map_config against the members of
+  // each class in one pass, without decoding, every missing required member,
+  // type mismatch and missing list is collected as "path: error"
+  bool validate_config();
+  list<string> get_errors() { return m_errors; }
   virtual bool build_config();
 
+  // streaming load, each site, building and ap is decoded and inserted into
+  // shim as soon as its record is read, without building the libconfig tree
+  // NOTE: members of a site or building must precede its child list
+  bool stream_config(const string &);
+
+  // zero-copy load, the file is mapped and tokenized in place into a compact
+  // tree instead of libconfig settings, parse_config then decodes the tree
+  bool map_config(const string &);
+
+  // reload the file loaded by map_config or reload_config, only sites,
+  // buildings and aps whose settings changed are decoded and inserted again,
+  // the others keep their objects and raise no notification. A failed reload
+  // leaves the records decoded before the failure in shim, the next reload
+  // completes it
+  bool reload_config(const string &);
+
+  // load from the binary snapshot next to the file, fn + ".snap", if it
+  // matches the content of the file and its includes, otherwise load and parse
+  // the file and write the snapshot for the next start
+  bool cache_config(const string &);
+  static uint64_t hash_config(const string &);
+
+  // with map_config, members of aps are decoded on first access instead of
+  // while loading, see object_config::set_lazy
+  void set_lazy(bool lazy) { m_lazy = lazy; }
+
+  // parse sites on n worker threads in parse_config, 0 or 1 for serial, with
+  // map_config the included files are also tokenized on n threads.
+  // reload_config is serial
+  void set_parallel(unsigned n) { m_n_threads = n; }
+
+  // per file tokenizing time of the last map_config on threads
+  const vector<cfg_reader::shard_stat> &get_shard_stats() const { return m_shard_stats; }
+
   list<string> get_added() { return added; }
   void set_added(list<string> i) { added = i; }
 
@@ -162,9 +204,96 @@ public:
   }
 
 private:
+  class stream_handler;
+  friend class stream_handler;
+  class lazy_record;
+  friend class lazy_record;
+
+  // meta_t::m_node compiled once into names and indexes, e.g. tls.dns_cache,
+  // a list of groups, e.g. groups.[%d].type, is split at [%d] into the path of
+  // the list and the path within each element
+  struct path_segment {
+    string m_name;
+    int m_index; // >= 0 for [n]
+  };
+  typedef vector<path_segment> node_path;
+
+  // typed decoder of one member, selected once per class by meta_t::m_vtype
+  struct field_decoder;
+  typedef void (*decoder_t)(const settings &, const field_decoder &,
+                            const member_t &);
+  typedef void (*tree_decoder_t)(const cfg_tree &, int, const field_decoder &,
+                                 const member_t &);
+  struct field_decoder {
+    const string *m_var;
+    const meta_t *m_meta;
+    decoder_t m_decode;
+    tree_decoder_t m_decode_tree;
+    node_path m_path;
+    node_path m_element;
+    bool m_groups;
+  };
+  typedef vector<field_decoder> decoder_table;
+
+  static const decoder_table &get_decoders(meta_map &);
+  static void compile_path(field_decoder &);
+  static const settings *resolve(const settings &, const node_path &);
+  static int resolve(const cfg_tree &, int, const node_path &);
+  static void check_required(const cfg_tree &, int, const decoder_table &);
+  static void check_range(const cfg_tree &, int, const decoder_table &);
+  void validate(const settings &, int, const decoder_table **);
+  void validate(const cfg_tree &, int, int, const decoder_table **);
+  void validate_record(const settings &, const decoder_table &);
+  void validate_record(const cfg_tree &, int, const decoder_table &);
+  template <typename T>
+  static void decode_scalar(const settings &, const field_decoder &,
+                            const member_t &);
+  // C is the container of member, e.g. list<int> or channel_set
+  template <typename C>
+  static void decode_list(const settings &, const field_decoder &,
+                          const member_t &);
+  static void decode_unknown(const settings &, const field_decoder &,
+                             const member_t &);
+  template <typename T>
+  static void decode_scalar(const cfg_tree &, int, const field_decoder &,
+                            const member_t &);
+  template <typename C>
+  static void decode_list(const cfg_tree &, int, const field_decoder &,
+                          const member_t &);
+  static void decode_unknown(const cfg_tree &, int, const field_decoder &,
+                             const member_t &);
+
+  object_config_ptr create_object(const string &, meta_map *&);
   string get_parent_path(const settings &);
-  void traverse(const settings &);
+  void traverse(const settings &, vector<object_config_ptr> * = nullptr);
+  void traverse_node(const string &, const settings &,
+                     vector<object_config_ptr> *);
+  void traverse_parallel(const settings &);
+  void prepare_decoders();
+  // hashes of a loaded site, building or ap record, with and without its
+  // child list, and the keys of its children
+  struct loaded_t {
+    uint64_t m_record;
+    uint64_t m_subtree;
+    vector<string> m_children;
+  };
+  typedef map<string, loaded_t> loaded_map;
+  typedef pair<uint64_t, uint64_t> hash_t; // record, subtree
+  enum { enum_n_levels = 3 };
+
+  void traverse_tree(int, const string &, const string &, loaded_map *,
+                     loaded_map *, vector<string> *,
+                     vector<object_config_ptr> * = nullptr);
+  void traverse_record(int, int, const string &, const string &, loaded_map *,
+                       loaded_map *, vector<string> *,
+                       vector<object_config_ptr> *);
+  void traverse_tree_parallel(int);
+  uint64_t hash_node(int, uint64_t, int) const;
+  uint64_t hash_records(int, int, const string &, const string &);
+  string record_key(int, int) const;
+  void keep_loaded(int, const string &, loaded_map *, loaded_map *);
   void build_traverse(shim &sh);
+  void build_object(const object_config_ptr &, settings *);
 
   object_config_ptr duplicate(const object_config_ptr &, int);
 
@@ -173,6 +302,14 @@ private:
   meta_map *m_src_meta;
   meta_map *m_dst_meta;
   list<string> added;
+  list<string> m_errors;
+  unsigned m_n_threads = 0;
+  vector<cfg_reader::shard_stat> m_shard_stats;
+  shared_ptr<cfg_tree> m_tree = make_shared<cfg_tree>();
+  bool m_mapped = false;
+  bool m_lazy = false;
+  loaded_map m_loaded[enum_n_levels];
+  unordered_map<int, hash_t> m_hashes;
 
 }; // class shim_cfg
 
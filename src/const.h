@@ -15,6 +15,32 @@ enum change_type
 
 extern const char *change_types[];
 
+// cbrs channels of channel_blacklist, channel n is [3550 + 5n, 3555 + 5n) MHz
+enum cbrs_channel_t
+{
+    enum_cbrs_base_khz = 3550000,
+    enum_cbrs_channel_khz = 5000,
+    enum_cbrs_n_channels = 30
+};
+
+// decoded type of member, resolved once from the schema macros so that
+// loaders can dispatch without comparing the type name
+enum var_type_t
+{
+    enum_type_string,
+    enum_type_bool,
+    enum_type_int,
+    enum_type_long,
+    enum_type_unsigned,
+    enum_type_double,
+    enum_type_list_int,
+    enum_type_list_string,
+    enum_type_istring,
+    enum_type_channel_set,
+    enum_type_string_vector,
+    enum_type_undefined
+};
+
 } // namespace project
 
 #endif // __CONST_H__
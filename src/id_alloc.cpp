@@ -0,0 +1,67 @@
+#include <stdexcept>
+
+#include "id_alloc.h"
+
+using namespace project;
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// id_allocator
+// map ids of one object type, thread safe
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// never destroyed, objects of static stores, e.g. shim, release their ids at
+// exit
+id_allocator &id_allocator::of_type(id_type_t type) {
+  static id_allocator *s_allocators[enum_id_n_types] = {
+    nullptr,
+    new id_allocator(enum_id_site),
+    new id_allocator(enum_id_building),
+    new id_allocator(enum_id_ap),
+    new id_allocator(enum_id_app)
+  };
+  if (type <= enum_id_none || type >= enum_id_n_types)
+    throw invalid_argument("no id allocator of type");
+  return *s_allocators[type];
+}
+
+uint64_t id_allocator::allocate() {
+  // most recently released index first, fresh index if none
+  if (m_n_free.load() != 0) {
+    lock_guard<mutex> lock(m_lock);
+    if (!m_free.empty()) {
+      pair<uint32_t, uint32_t> f = m_free.back();
+      m_free.pop_back();
+      m_n_free.store(m_free.size());
+      return make_id(f.first, f.second);
+    }
+  }
+  // m_next never moves past the last index, so that it stays exhausted
+  // instead of wrapping to index 0
+  uint32_t index = m_next.load();
+  do {
+    if (index == UINT32_MAX)
+      throw overflow_error("map id indexes exhausted");
+  } while (!m_next.compare_exchange_weak(index, index + 1));
+  return make_id(index, 0);
+}
+
+void id_allocator::release(uint64_t map_id) {
+  if (type_of(map_id) != m_type)
+    return;
+  uint32_t gen = (uint32_t)(map_id >> enum_shift_gen) & 0xfffffff;
+  lock_guard<mutex> lock(m_lock);
+  m_free.emplace_back(index_of(map_id), gen + 1);
+  m_n_free.store(m_free.size());
+}
+
+size_t id_allocator::get_n_free() {
+  lock_guard<mutex> lock(m_lock);
+  return m_free.size();
+}
+
+} // namespace project
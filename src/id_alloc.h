@@ -0,0 +1,76 @@
+#ifndef __ID_ALLOC_H__
+#define __ID_ALLOC_H__
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace project {
+
+// object type in the top bits of map id
+enum id_type_t {
+  enum_id_none,
+  enum_id_site,
+  enum_id_building,
+  enum_id_ap,
+  enum_id_app,
+  enum_id_n_types
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// id_allocator
+// map ids of one object type, thread safe. A map id is the type in bits 60
+// to 63, the generation of the index in bits 32 to 59 and the index in bits
+// 0 to 31. Released indexes are reused with the next generation, so that the
+// id of a released object does not match a live one, and the indexes of live
+// objects stay dense
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class id_allocator {
+public:
+  enum { enum_shift_type = 60, enum_shift_gen = 32 };
+
+  // allocator of type, one per type for the process
+  static id_allocator &of_type(id_type_t);
+
+  uint64_t allocate();
+  // id must be allocated and not released yet, ids of other types are ignored
+  void release(uint64_t);
+
+  // indexes ever handed out, i.e. the bound of live indexes
+  uint32_t get_n_indexes() const { return m_next.load(); }
+  size_t get_n_free();
+
+  static id_type_t type_of(uint64_t map_id) {
+    uint64_t t = map_id >> enum_shift_type;
+    return t < enum_id_n_types ? (id_type_t)t : enum_id_none;
+  }
+  static uint32_t index_of(uint64_t map_id) { return (uint32_t)map_id; }
+
+private:
+  explicit id_allocator(id_type_t type) : m_type(type), m_next(0), m_n_free(0) {}
+  id_allocator(const id_allocator &) = delete;
+  id_allocator &operator=(const id_allocator &) = delete;
+
+  uint64_t make_id(uint32_t index, uint32_t gen) const {
+    return ((uint64_t)m_type << enum_shift_type)
+           | ((uint64_t)(gen & 0xfffffff) << enum_shift_gen) | index;
+  }
+
+  id_type_t m_type;
+  atomic<uint32_t> m_next;   // next index never handed out
+  atomic<size_t> m_n_free;   // size of free list, read without the lock
+  mutex m_lock;
+  vector<pair<uint32_t, uint32_t>> m_free; // index and its next generation
+
+}; // class id_allocator
+
+} // namespace project
+
+#endif // __ID_ALLOC_H__
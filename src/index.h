@@ -0,0 +1,563 @@
+#ifndef __INDEX_H__
+#define __INDEX_H__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "id_alloc.h"
+
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// span_view
+// read-only view of a contiguous range, valid until the range is changed
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T> class span_view {
+public:
+  span_view(const T *data, size_t size) : m_data(data), m_size(size) {}
+
+  const T *begin() const { return m_data; }
+  const T *end() const { return m_data + m_size; }
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  const T &operator[](size_t i) const { return m_data[i]; }
+
+private:
+  const T *m_data;
+  size_t m_size;
+
+}; // class span_view
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// store_index
+// flat index of shim store, values are kept in a slot array. Keys are found
+// by open addressing over a table of (hash tag, slot), ids by a dense table
+// per object type indexed by the index part of map id. Live entries are
+// linked in insertion order, erase unlinks in O(1) and replace keeps the
+// position
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename V> class store_index {
+public:
+  struct entry {
+    string m_key;
+    uint64_t m_id;
+    V m_val;
+    bool m_live;
+    int m_prev; // insertion order, -1 at either end
+    int m_next;
+  };
+
+  // values of live entries in insertion order, valid until the index is
+  // changed
+  class ordered_range {
+  public:
+    class iterator {
+    public:
+      iterator(const store_index *ix, int slot) : m_ix(ix), m_slot(slot) {}
+      const V &operator*() const { return m_ix->m_slots[m_slot].m_val; }
+      const V *operator->() const { return &m_ix->m_slots[m_slot].m_val; }
+      iterator &operator++() {
+        m_slot = m_ix->m_slots[m_slot].m_next;
+        return *this;
+      }
+      bool operator==(const iterator &o) const { return m_slot == o.m_slot; }
+      bool operator!=(const iterator &o) const { return m_slot != o.m_slot; }
+
+    private:
+      const store_index *m_ix;
+      int m_slot;
+    };
+
+    explicit ordered_range(const store_index *ix) : m_ix(ix) {}
+    iterator begin() const { return iterator(m_ix, m_ix->m_head); }
+    iterator end() const { return iterator(m_ix, -1); }
+    size_t size() const { return m_ix->size(); }
+    bool empty() const { return m_ix->size() == 0; }
+
+  private:
+    const store_index *m_ix;
+  };
+
+  store_index() { clear(); }
+
+  void clear() {
+    m_slots.clear();
+    m_free.clear();
+    m_table.assign(enum_min_buckets, bucket{ 0, enum_empty });
+    m_used = 0;
+    m_head = m_tail = -1;
+    for (auto &t : m_ids)
+      t.clear();
+  }
+
+  size_t size() const { return m_slots.size() - m_free.size(); }
+
+  // slot of key or id, -1 if not found
+  int find(string_view key) const {
+    uint64_t h = hash(key);
+    size_t mask = m_table.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+      const bucket &b = m_table[i];
+      if (b.m_slot == enum_empty)
+        return -1;
+      if (b.m_slot >= 0 && b.m_tag == (uint32_t)h && m_slots[b.m_slot].m_key == key)
+        return b.m_slot;
+    }
+  }
+
+  int find(uint64_t id) const {
+    size_t level, idx;
+    if (!id_index(id, level, idx) || idx >= m_ids[level].size())
+      return -1;
+    int slot = m_ids[level][idx];
+    return (slot >= 0 && m_slots[slot].m_id == id) ? slot : -1;
+  }
+
+  const entry &at(int slot) const { return m_slots[slot]; }
+  entry &at(int slot) { return m_slots[slot]; }
+
+  ordered_range ordered() const { return ordered_range(this); }
+
+  // add key which must not be in the index at the end of insertion order,
+  // return its slot
+  int insert(const string &key, uint64_t id, const V &val) {
+    if ((m_used + 1) * 2 > m_table.size())
+      // grow, or only drop deleted marks if few entries are live
+      rehash(size() * 4 >= m_table.size() ? m_table.size() * 2 : m_table.size());
+
+    int slot;
+    if (!m_free.empty()) {
+      slot = m_free.back();
+      m_free.pop_back();
+    }
+    else {
+      slot = (int)m_slots.size();
+      m_slots.emplace_back();
+    }
+    entry &e = m_slots[slot];
+    e.m_key = key;
+    e.m_id = id;
+    e.m_val = val;
+    e.m_live = true;
+    e.m_prev = m_tail;
+    e.m_next = -1;
+    (m_tail >= 0 ? m_slots[m_tail].m_next : m_head) = slot;
+    m_tail = slot;
+
+    uint64_t h = hash(key);
+    size_t mask = m_table.size() - 1;
+    size_t i = h & mask;
+    while (m_table[i].m_slot >= 0)
+      i = (i + 1) & mask;
+    if (m_table[i].m_slot == enum_empty)
+      ++m_used;
+    m_table[i] = bucket{ (uint32_t)h, slot };
+
+    set_id(id, slot);
+    return slot;
+  }
+
+  // change id and value of entry in place, the key and position in
+  // insertion order are kept
+  void replace(int slot, uint64_t id, const V &val) {
+    entry &e = m_slots[slot];
+    if (e.m_id != id) {
+      clear_id(e.m_id, slot);
+      e.m_id = id;
+      set_id(id, slot);
+    }
+    e.m_val = val;
+  }
+
+  // remove entry, the slot is reused by later inserts
+  void erase(int slot) {
+    entry &e = m_slots[slot];
+    uint64_t h = hash(e.m_key);
+    size_t mask = m_table.size() - 1;
+    for (size_t i = h & mask; m_table[i].m_slot != enum_empty; i = (i + 1) & mask)
+      if (m_table[i].m_slot == slot) {
+        m_table[i].m_slot = enum_deleted;
+        break;
+      }
+    clear_id(e.m_id, slot);
+    (e.m_prev >= 0 ? m_slots[e.m_prev].m_next : m_head) = e.m_next;
+    (e.m_next >= 0 ? m_slots[e.m_next].m_prev : m_tail) = e.m_prev;
+    e.m_key.clear();
+    e.m_val = V();
+    e.m_live = false;
+    m_free.push_back(slot);
+  }
+
+  // live entries in slot order
+  template <typename F> void for_each(F f) const {
+    for (const auto &e : m_slots)
+      if (e.m_live)
+        f(e);
+  }
+
+private:
+  enum { enum_min_buckets = 16, enum_empty = -1, enum_deleted = -2 };
+
+  struct bucket {
+    uint32_t m_tag; // low bits of key hash, compared before the key
+    int32_t m_slot;
+  };
+
+  static uint64_t hash(string_view key) {
+    uint64_t h = std::hash<string_view>()(key);
+    return h ^ (h >> 32);
+  }
+
+  // dense table of each type by index of map id, see id_allocator
+  static bool id_index(uint64_t id, size_t &level, size_t &idx) {
+    id_type_t type = id_allocator::type_of(id);
+    if (type == enum_id_none)
+      return false;
+    level = type - 1;
+    idx = id_allocator::index_of(id);
+    return true;
+  }
+
+  void set_id(uint64_t id, int slot) {
+    size_t level, idx;
+    if (!id_index(id, level, idx))
+      return;
+    vector<int32_t> &t = m_ids[level];
+    if (idx >= t.size())
+      t.resize(max(idx + 1, t.size() * 2), -1);
+    t[idx] = slot;
+  }
+
+  void clear_id(uint64_t id, int slot) {
+    size_t level, idx;
+    if (id_index(id, level, idx) && idx < m_ids[level].size()
+        && m_ids[level][idx] == slot)
+      m_ids[level][idx] = -1;
+  }
+
+  // rebuild table with n buckets, drops deleted marks
+  void rehash(size_t n) {
+    m_table.assign(n, bucket{ 0, enum_empty });
+    m_used = 0;
+    size_t mask = n - 1;
+    for (size_t s = 0; s < m_slots.size(); ++s) {
+      if (!m_slots[s].m_live)
+        continue;
+      uint64_t h = hash(m_slots[s].m_key);
+      size_t i = h & mask;
+      while (m_table[i].m_slot != enum_empty)
+        i = (i + 1) & mask;
+      m_table[i] = bucket{ (uint32_t)h, (int32_t)s };
+      ++m_used;
+    }
+  }
+
+  vector<entry> m_slots;
+  vector<int> m_free;
+  vector<bucket> m_table; // power of 2 buckets, at most half used
+  size_t m_used;          // buckets not empty, including deleted marks
+  int m_head, m_tail;     // first and last slot in insertion order
+  vector<int32_t> m_ids[enum_id_n_types - 1];
+
+}; // class store_index
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// value_index
+// secondary index of map ids by the value of one field. The value of each id
+// is kept as well, so that an id is moved or removed without its old value
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class value_index {
+public:
+  typedef unordered_set<uint64_t> id_set;
+
+  // add id or move it to value
+  void insert(uint64_t id, const string &value) {
+    auto v = m_values.find(id);
+    if (v != m_values.end()) {
+      if (v->second == value)
+        return;
+      remove(id, v->second);
+      v->second = value;
+    }
+    else
+      m_values.emplace(id, value);
+    m_ids[value].insert(id);
+  }
+
+  void erase(uint64_t id) {
+    auto v = m_values.find(id);
+    if (v == m_values.end())
+      return;
+    remove(id, v->second);
+    m_values.erase(v);
+  }
+
+  // ids of value, null if none
+  const id_set *find(const string &value) const {
+    auto i = m_ids.find(value);
+    return i != m_ids.end() ? &i->second : nullptr;
+  }
+
+  size_t count(const string &value) const {
+    const id_set *ids = find(value);
+    return ids ? ids->size() : 0;
+  }
+
+  // value of id, null if not indexed
+  const string *value_of(uint64_t id) const {
+    auto v = m_values.find(id);
+    return v != m_values.end() ? &v->second : nullptr;
+  }
+
+  size_t size() const { return m_values.size(); }
+  size_t n_values() const { return m_ids.size(); }
+
+  void clear() {
+    m_ids.clear();
+    m_values.clear();
+  }
+
+private:
+  void remove(uint64_t id, const string &value) {
+    auto i = m_ids.find(value);
+    if (i == m_ids.end())
+      return;
+    i->second.erase(id);
+    if (i->second.empty())
+      m_ids.erase(i);
+  }
+
+  unordered_map<string, id_set> m_ids;
+  unordered_map<uint64_t, string> m_values;
+
+}; // class value_index
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// grid_index
+// spatial index of map ids by latitude and longitude in degrees. Points are
+// kept in cells of a uniform grid, a query visits only the cells overlapping
+// its bounding box, or the occupied cells if these are fewer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class grid_index {
+public:
+  explicit grid_index(double cell_deg = 0.01) : m_cell(cell_deg) {}
+
+  // add id or move it to (lat, lon), points which are not finite are dropped
+  void insert(uint64_t id, double lat, double lon) {
+    erase(id);
+    if (!std::isfinite(lat) || !std::isfinite(lon))
+      return;
+    uint64_t c = cell_key(row(lat), col(lon));
+    vector<point> &pts = m_cells[c];
+    m_places[id] = place{ c, pts.size() };
+    pts.push_back(point{ id, lat, lon });
+  }
+
+  void erase(uint64_t id) {
+    auto p = m_places.find(id);
+    if (p == m_places.end())
+      return;
+    auto c = m_cells.find(p->second.m_cell);
+    vector<point> &pts = c->second;
+    size_t pos = p->second.m_pos;
+    if (pos + 1 != pts.size()) {
+      pts[pos] = pts.back();
+      m_places[pts[pos].m_id].m_pos = pos;
+    }
+    pts.pop_back();
+    if (pts.empty())
+      m_cells.erase(c);
+    m_places.erase(p);
+  }
+
+  size_t size() const { return m_places.size(); }
+
+  void clear() {
+    m_cells.clear();
+    m_places.clear();
+  }
+
+  // f(id, lat, lon) for points with lat0 <= lat <= lat1 and lon0 <= lon <= lon1,
+  // a box with lon0 > lon1 crosses the antimeridian
+  template <typename F>
+  void for_each_in_box(double lat0, double lat1, double lon0, double lon1, F f) const {
+    if (lon0 > lon1) {
+      for_each_in_box(lat0, lat1, lon0, 180.0, f);
+      for_each_in_box(lat0, lat1, -180.0, lon1, f);
+      return;
+    }
+    if (lat0 > lat1)
+      return;
+    int64_t r0 = row(lat0), r1 = row(lat1), c0 = col(lon0), c1 = col(lon1);
+    auto visit = [&](const vector<point> &pts) {
+      for (const point &p : pts)
+        if (p.m_lat >= lat0 && p.m_lat <= lat1 && p.m_lon >= lon0 && p.m_lon <= lon1)
+          f(p.m_id, p.m_lat, p.m_lon);
+    };
+    if ((double)(r1 - r0 + 1) * (double)(c1 - c0 + 1) > (double)m_cells.size()) {
+      for (const auto &c : m_cells) {
+        int64_t r = (int32_t)(c.first >> 32), k = (int32_t)(uint32_t)c.first;
+        if (r >= r0 && r <= r1 && k >= c0 && k <= c1)
+          visit(c.second);
+      }
+      return;
+    }
+    for (int64_t r = r0; r <= r1; ++r)
+      for (int64_t k = c0; k <= c1; ++k) {
+        auto c = m_cells.find(cell_key(r, k));
+        if (c != m_cells.end())
+          visit(c->second);
+      }
+  }
+
+  // f(id, lat, lon) for points within meters of (lat, lon) on the sphere
+  template <typename F>
+  void for_each_in_radius(double lat, double lon, double meters, F f) const {
+    if (!(meters >= 0))
+      return;
+    // bounding box of the circle, all longitudes if it covers a pole
+    double d = meters / s_earth_radius_m, lat0, lat1, lon0 = -180.0, lon1 = 180.0;
+    double rad = M_PI / 180.0;
+    lat0 = lat - d / rad;
+    lat1 = lat + d / rad;
+    if (lat0 > -90.0 && lat1 < 90.0) {
+      double dlon = asin(min(1.0, sin(d) / cos(lat * rad))) / rad;
+      if (dlon < 180.0) {
+        lon0 = lon - dlon;
+        lon1 = lon + dlon;
+        if (lon0 < -180.0)
+          lon0 += 360.0;
+        if (lon1 > 180.0)
+          lon1 -= 360.0;
+      }
+    }
+    for_each_in_box(max(lat0, -90.0), min(lat1, 90.0), lon0, lon1,
+                    [&](uint64_t id, double plat, double plon) {
+      if (distance_m(lat, lon, plat, plon) <= meters)
+        f(id, plat, plon);
+    });
+  }
+
+  // great circle distance by haversine
+  static double distance_m(double lat0, double lon0, double lat1, double lon1) {
+    double rad = M_PI / 180.0;
+    double a = sin((lat1 - lat0) * rad / 2), b = sin((lon1 - lon0) * rad / 2);
+    double h = a * a + cos(lat0 * rad) * cos(lat1 * rad) * b * b;
+    return 2 * s_earth_radius_m * asin(min(1.0, sqrt(h)));
+  }
+
+private:
+  // points are kept in their cell so that a query reads cells in sequence
+  struct point {
+    uint64_t m_id;
+    double m_lat;
+    double m_lon;
+  };
+  struct place {
+    uint64_t m_cell;
+    size_t m_pos; // position in points of cell
+  };
+
+  static constexpr double s_earth_radius_m = 6371008.8;
+
+  int64_t row(double lat) const { return (int64_t)floor(lat / m_cell); }
+  int64_t col(double lon) const { return (int64_t)floor(lon / m_cell); }
+  static uint64_t cell_key(int64_t r, int64_t c) {
+    return ((uint64_t)(uint32_t)r << 32) | (uint32_t)c;
+  }
+
+  double m_cell;
+  unordered_map<uint64_t, vector<point>> m_cells;
+  unordered_map<uint64_t, place> m_places;
+
+}; // class grid_index
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// interval_index
+// index of map ids by half open interval [lo, hi), e.g. the band of an ap in
+// kHz. Intervals are sorted by lo, a query starts at lo minus the largest
+// width, so that it visits the overlapping intervals and those starting
+// within that width before them only
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class interval_index {
+public:
+  // add id or move it to [lo, hi), empty intervals are dropped
+  void insert(uint64_t id, uint64_t lo, uint64_t hi) {
+    erase(id);
+    if (lo >= hi)
+      return;
+    m_pos[id] = m_by_lo.emplace(lo, span{ hi, id });
+    ++m_widths[hi - lo];
+  }
+
+  void erase(uint64_t id) {
+    auto p = m_pos.find(id);
+    if (p == m_pos.end())
+      return;
+    auto w = m_widths.find(p->second->second.m_hi - p->second->first);
+    if (--w->second == 0)
+      m_widths.erase(w);
+    m_by_lo.erase(p->second);
+    m_pos.erase(p);
+  }
+
+  size_t size() const { return m_pos.size(); }
+
+  void clear() {
+    m_by_lo.clear();
+    m_pos.clear();
+    m_widths.clear();
+  }
+
+  // f(id, lo, hi) for intervals overlapping [lo, hi) in order of lo
+  template <typename F> void for_each_overlap(uint64_t lo, uint64_t hi, F f) const {
+    if (m_widths.empty() || lo >= hi)
+      return;
+    uint64_t max_width = m_widths.rbegin()->first;
+    auto i = lo >= max_width ? m_by_lo.upper_bound(lo - max_width) : m_by_lo.begin();
+    for (; i != m_by_lo.end() && i->first < hi; ++i)
+      if (i->second.m_hi > lo)
+        f(i->second.m_id, i->first, i->second.m_hi);
+  }
+
+private:
+  struct span {
+    uint64_t m_hi;
+    uint64_t m_id;
+  };
+  typedef multimap<uint64_t, span> span_map;
+
+  span_map m_by_lo;
+  unordered_map<uint64_t, span_map::iterator> m_pos;
+  map<uint64_t, size_t> m_widths; // count of intervals by width
+
+}; // class interval_index
+
+} // namespace project
+
+#endif // __INDEX_H__
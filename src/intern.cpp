@@ -0,0 +1,52 @@
+#include <mutex>
+
+#include "intern.h"
+
+using namespace project;
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// intern_pool
+// deduplicated strings of the process, thread safe
+//
+///////////////////////////////////////////////////////////////////////////////
+
+intern_pool &intern_pool::instance() {
+  static intern_pool *s_instance = new intern_pool();
+  return *s_instance;
+}
+
+intern_pool::intern_pool() : m_bytes(0) {
+  m_empty = &*m_strings.insert(string()).first;
+}
+
+const string *intern_pool::intern(const string &s) {
+  if (s.empty())
+    return m_empty;
+  {
+    shared_lock<shared_mutex> lock(m_lock);
+    auto it = m_strings.find(s);
+    if (it != m_strings.end())
+      return &*it;
+  }
+  unique_lock<shared_mutex> lock(m_lock);
+  auto r = m_strings.insert(s);
+  if (r.second)
+    m_bytes += s.size();
+  return &*r.first;
+}
+
+size_t intern_pool::size() {
+  shared_lock<shared_mutex> lock(m_lock);
+  return m_strings.size();
+}
+
+size_t intern_pool::get_n_bytes() {
+  shared_lock<shared_mutex> lock(m_lock);
+  return m_bytes;
+}
+
+} // namespace project
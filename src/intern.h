@@ -0,0 +1,94 @@
+#ifndef __INTERN_H__
+#define __INTERN_H__
+
+#include <cstddef>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <unordered_set>
+
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// intern_pool
+// deduplicated strings of the process, thread safe. A string is stored once
+// and never freed, so that its address is a handle valid until exit. Meant
+// for values repeated across many objects, e.g. vendor or site_name, not for
+// unique ones
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class intern_pool {
+public:
+  // never destroyed, objects of static stores, e.g. shim, use it at exit
+  static intern_pool &instance();
+
+  // stored copy of s, the same for equal strings
+  const string *intern(const string &);
+  const string *empty() const { return m_empty; }
+
+  // distinct strings and their bytes
+  size_t size();
+  size_t get_n_bytes();
+
+private:
+  intern_pool();
+  intern_pool(const intern_pool &) = delete;
+  intern_pool &operator=(const intern_pool &) = delete;
+
+  shared_mutex m_lock;
+  unordered_set<string> m_strings; // nodes do not move on rehash
+  size_t m_bytes;
+  const string *m_empty;
+
+}; // class intern_pool
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// istring
+// handle of interned string, read as const string &. Equal handles are equal
+// strings, so that comparing two of them is comparing pointers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class istring {
+public:
+  istring() : m_str(intern_pool::instance().empty()) {}
+  istring(const string &s) : m_str(intern_pool::instance().intern(s)) {}
+  istring(const char *s) : m_str(intern_pool::instance().intern(s)) {}
+
+  const string &str() const { return *m_str; }
+  operator const string &() const { return *m_str; }
+  const char *c_str() const { return m_str->c_str(); }
+  size_t size() const { return m_str->size(); }
+  bool empty() const { return m_str->empty(); }
+  // handle, the same for equal strings
+  const string *get() const { return m_str; }
+
+  bool operator==(const istring &rhs) const { return m_str == rhs.m_str; }
+  bool operator!=(const istring &rhs) const { return m_str != rhs.m_str; }
+  bool operator<(const istring &rhs) const { return *m_str < *rhs.m_str; }
+
+private:
+  const string *m_str;
+
+}; // class istring
+
+inline bool operator==(const istring &a, const string &b) { return a.str() == b; }
+inline bool operator==(const string &a, const istring &b) { return a == b.str(); }
+inline bool operator!=(const istring &a, const string &b) { return a.str() != b; }
+inline bool operator!=(const string &a, const istring &b) { return a != b.str(); }
+inline bool operator==(const istring &a, const char *b) { return a.str() == b; }
+inline bool operator!=(const istring &a, const char *b) { return a.str() != b; }
+inline string operator+(const istring &a, const string &b) { return a.str() + b; }
+inline string operator+(const string &a, const istring &b) { return a + b.str(); }
+inline string operator+(const istring &a, const char *b) { return a.str() + b; }
+inline string operator+(const char *a, const istring &b) { return a + b.str(); }
+inline ostream &operator<<(ostream &os, const istring &s) { return os << s.str(); }
+
+} // namespace project
+
+#endif // __INTERN_H__
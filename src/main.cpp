@@ -1,9 +1,11 @@
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
 #include <getopt.h>
 #include <unistd.h>
 
+#include "bench.h"
 #include "config.h"
 #include "shim.h"
 
@@ -11,14 +13,37 @@ using namespace project;
 using namespace std;
 
 
-void load_from_cfg(const string &cfg)
+enum load_t
+{
+    enum_load_libconfig,
+    enum_load_stream,
+    enum_load_mmap,
+    enum_load_cache
+};
+
+void load_from_cfg(const string &cfg, load_t load, unsigned n_threads)
 {
     // load object config if cfg file provided
     cout << "loading " << cfg << " ..." << endl;
     shim_cfg c;
-    if (c.load_config(cfg))
+    c.set_parallel(n_threads);
+    bool loaded = false;
+    if (load == enum_load_stream)
+        loaded = c.stream_config(cfg);
+    else if (load == enum_load_mmap)
     {
-        if (c.parse_config())
+        loaded = c.map_config(cfg);
+        for (const auto &st : c.get_shard_stats())
+            cout << "  " << st.m_file << ": " << st.m_n_tokens << " tokens, "
+                 << st.m_ms << " ms" << endl;
+    }
+    else if (load == enum_load_cache)
+        loaded = c.cache_config(cfg);
+    else
+        loaded = c.load_config(cfg);
+    if (loaded)
+    {
+        if (load == enum_load_stream || load == enum_load_cache || c.parse_config())
         {
             cout << "sucessfully loaded " << cfg << endl;
             c.build_config();
@@ -80,6 +105,71 @@ void migrate_from_cfg(const string &cfg) {
     }
 }
 
+void validate_cfg(const string &cfg, load_t load)
+{
+    // report all errors of cfg file in one pass
+    cout << "validating " << cfg << " ..." << endl;
+    shim_cfg c;
+    bool loaded = (load == enum_load_mmap ? c.map_config(cfg) : c.load_config(cfg));
+    if (!loaded)
+        cerr << "failed to load " << cfg << ", " << c.get_error() << endl;
+    else if (c.validate_config())
+        cout << cfg << " is valid" << endl;
+    else
+    {
+        for (const auto &e : c.get_errors())
+            cerr << e << endl;
+        cerr << c.get_errors().size() << " errors in " << cfg << endl;
+    }
+}
+
+void query_cfg(const string &cfg, load_t load, const string &terms)
+{
+    // aps matching field=value terms separated by commas
+    shim_cfg c;
+    bool loaded = false;
+    if (load == enum_load_stream)
+        loaded = c.stream_config(cfg);
+    else if (load == enum_load_cache)
+        loaded = c.cache_config(cfg);
+    else if (load == enum_load_mmap)
+        loaded = c.map_config(cfg) && c.parse_config();
+    else
+        loaded = c.load_config(cfg) && c.parse_config();
+    if (!loaded)
+    {
+        cerr << "failed to load " << cfg << ", " << c.get_error() << endl;
+        return;
+    }
+
+    shim::query_t q;
+    size_t pos = 0;
+    while (pos <= terms.size())
+    {
+        size_t end = terms.find(',', pos);
+        if (end == string::npos)
+            end = terms.size();
+        string term = terms.substr(pos, end - pos);
+        size_t eq = term.find('=');
+        if (eq == string::npos)
+        {
+            cerr << "invalid query term, " << term << endl;
+            return;
+        }
+        q.emplace_back(term.substr(0, eq), term.substr(eq + 1));
+        pos = end + 1;
+    }
+
+    shim &sh = shim::instance();
+    for (const char *f : { "fcc_id", "serial_number", "vendor", "model",
+                           "firmware_version", "site_name", "building_name" })
+        sh.create_index(f);
+    vector<object_config_ptr> aps = sh.query(q);
+    for (const auto &ap : aps)
+        cout << ap->get_key() << endl;
+    cout << aps.size() << " aps matched" << endl;
+}
+
 void read_cfg_meta(const string &cfg)
 {
     // load object config if cfg file provided
@@ -99,21 +189,37 @@ int main(int argc, char *argv[])
     enum op_t
     {
         enum_op_meta,
+        enum_op_bench,
+        enum_op_validate,
+        enum_op_query,
         enum_op_default
     };
     op_t op = enum_op_default;
     string obj_cfg;
+    string bench_name;
+    string query_terms;
+    int bench_iterations = 1;
+    load_t load = enum_load_libconfig;
+    unsigned n_threads = 0;
 
     // parse cmd line arguments
     static struct option options[] =
     {
         { "meta", no_argument, 0, 'm' },
         { "incfg", required_argument, 0, 'i' },
+        { "bench", required_argument, 0, 'b' },
+        { "iterations", required_argument, 0, 'n' },
+        { "stream", no_argument, 0, 's' },
+        { "parallel", required_argument, 0, 'p' },
+        { "mmap", no_argument, 0, 'z' },
+        { "cache", no_argument, 0, 'c' },
+        { "validate", no_argument, 0, 'v' },
+        { "query", required_argument, 0, 'q' },
         { 0, 0, 0, 0 }
     };
 
     int opt = 0, idx = 0;
-    while ((opt = getopt_long(argc, argv, "mi:", options, &idx)) != -1)
+    while ((opt = getopt_long(argc, argv, "mi:b:n:sp:zcvq:", options, &idx)) != -1)
     {
         switch (opt)
         {
@@ -123,6 +229,32 @@ int main(int argc, char *argv[])
             case 'i':
                 obj_cfg = optarg;
                 break;
+            case 'b':
+                op = enum_op_bench;
+                bench_name = optarg;
+                break;
+            case 'n':
+                bench_iterations = atoi(optarg);
+                break;
+            case 's':
+                load = enum_load_stream;
+                break;
+            case 'p':
+                n_threads = atoi(optarg);
+                break;
+            case 'z':
+                load = enum_load_mmap;
+                break;
+            case 'c':
+                load = enum_load_cache;
+                break;
+            case 'v':
+                op = enum_op_validate;
+                break;
+            case 'q':
+                op = enum_op_query;
+                query_terms = optarg;
+                break;
             default:
                 cerr << "unknown argument" << endl;
                 break;
@@ -135,7 +267,7 @@ int main(int argc, char *argv[])
             cerr << "no cfg file" << endl;
         else
         {
-            load_from_cfg(obj_cfg);
+            load_from_cfg(obj_cfg, load, n_threads);
             migrate_from_cfg(obj_cfg);
         }
 #if 0
@@ -152,6 +284,25 @@ int main(int argc, char *argv[])
         else
             cerr << "no cfg file" << endl;
     }
+    else if (op == enum_op_validate)
+    {
+        if (!obj_cfg.empty())
+            validate_cfg(obj_cfg, load);
+        else
+            cerr << "no cfg file" << endl;
+    }
+    else if (op == enum_op_query)
+    {
+        if (!obj_cfg.empty())
+            query_cfg(obj_cfg, load, query_terms);
+        else
+            cerr << "no cfg file" << endl;
+    }
+    else if (op == enum_op_bench)
+    {
+        if (!bench_run(bench_name, obj_cfg, bench_iterations))
+            cerr << "benchmark " << bench_name << " failed" << endl;
+    }
 
     cout << "done." << endl;
     return 0;
@@ -0,0 +1,121 @@
+#include <utility>
+
+#include "rcu.h"
+
+using namespace project;
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// rcu_domain
+// epoch based reclamation for read-mostly data
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// slots of the calling thread, one per domain, released at thread exit
+// NOTE: a domain must outlive the threads reading from it
+struct rcu_thread_slots {
+  vector<pair<const rcu_domain *, void *>> m_slots;
+  vector<atomic<bool> *> m_used;
+
+  ~rcu_thread_slots() {
+    for (auto u : m_used)
+      u->store(false);
+  }
+};
+
+static thread_local rcu_thread_slots t_slots;
+
+rcu_domain::rcu_domain() : m_epoch(1) {}
+
+rcu_domain::~rcu_domain() {
+  for (const auto &r : m_retired)
+    r.m_del(r.m_ptr);
+}
+
+rcu_domain::reader_slot *rcu_domain::get_slot() {
+  for (const auto &s : t_slots.m_slots)
+    if (s.first == this)
+      return static_cast<reader_slot *>(s.second);
+
+  reader_slot *slot = nullptr;
+  {
+    lock_guard<mutex> lock(m_lock);
+    for (const auto &s : m_slots) {
+      bool used = false;
+      if (s->m_used.compare_exchange_strong(used, true)) {
+        slot = s.get();
+        break;
+      }
+    }
+    if (!slot) {
+      m_slots.emplace_back(new reader_slot());
+      slot = m_slots.back().get();
+      slot->m_epoch = 0;
+      slot->m_used = true;
+    }
+    slot->m_depth = 0;
+  }
+  t_slots.m_slots.emplace_back(this, slot);
+  t_slots.m_used.push_back(&slot->m_used);
+  return slot;
+}
+
+void rcu_domain::read_lock() {
+  reader_slot *s = get_slot();
+  // the epoch is announced before any pointer of the domain is read. The
+  // fence orders the store before the loads of the caller, which may be
+  // acquire only, it pairs with the fence of reclaim_locked
+  if (s->m_depth++ == 0) {
+    s->m_epoch.store(m_epoch.load());
+    atomic_thread_fence(memory_order_seq_cst);
+  }
+}
+
+void rcu_domain::read_unlock() {
+  reader_slot *s = get_slot();
+  if (--s->m_depth == 0)
+    s->m_epoch.store(0, memory_order_release);
+}
+
+void rcu_domain::retire(void *p, void (*del)(void *)) {
+  lock_guard<mutex> lock(m_lock);
+  // readers announced from the next epoch on load the replacement of p
+  retired_t r = { p, del, m_epoch.fetch_add(1) };
+  m_retired.push_back(r);
+  reclaim_locked();
+}
+
+void rcu_domain::reclaim() {
+  lock_guard<mutex> lock(m_lock);
+  reclaim_locked();
+}
+
+size_t rcu_domain::get_n_retired() {
+  lock_guard<mutex> lock(m_lock);
+  return m_retired.size();
+}
+
+void rcu_domain::reclaim_locked() {
+  // the replacements published before are visible to readers whose epoch is
+  // not seen here
+  atomic_thread_fence(memory_order_seq_cst);
+  uint64_t oldest = UINT64_MAX;
+  for (const auto &s : m_slots) {
+    uint64_t e = s->m_epoch.load();
+    if (e != 0 && e < oldest)
+      oldest = e;
+  }
+  size_t n = 0;
+  for (const auto &r : m_retired) {
+    if (r.m_epoch < oldest)
+      r.m_del(r.m_ptr);
+    else
+      m_retired[n++] = r;
+  }
+  m_retired.resize(n);
+}
+
+} // namespace project
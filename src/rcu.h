@@ -0,0 +1,69 @@
+#ifndef __RCU_H__
+#define __RCU_H__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// rcu_domain
+// epoch based reclamation for read-mostly data. Readers announce the epoch
+// they read in and never block, writers publish a new version and retire the
+// old one, which is deleted once no reader is left in its epoch
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class rcu_domain {
+public:
+  rcu_domain();
+  ~rcu_domain();
+
+  // read side of calling thread, may be nested, pointers read from the
+  // domain stay valid until the outermost unlock
+  void read_lock();
+  void read_unlock();
+
+  // delete p with del once all readers in the current epoch have left,
+  // called by writers after the replacement of p is published
+  void retire(void *p, void (*del)(void *));
+
+  // delete retired objects no reader can see anymore
+  void reclaim();
+  size_t get_n_retired();
+
+private:
+  rcu_domain(const rcu_domain &) = delete;
+  rcu_domain &operator=(const rcu_domain &) = delete;
+
+  // one per reader thread, reused once the thread exits
+  struct reader_slot {
+    atomic<uint64_t> m_epoch; // 0 if not reading
+    atomic<bool> m_used;
+    int m_depth;              // nesting, owned by the thread
+  };
+  struct retired_t {
+    void *m_ptr;
+    void (*m_del)(void *);
+    uint64_t m_epoch;
+  };
+
+  reader_slot *get_slot();
+  void reclaim_locked();
+
+  atomic<uint64_t> m_epoch;
+  mutex m_lock; // slot registration and retired list
+  vector<unique_ptr<reader_slot>> m_slots;
+  vector<retired_t> m_retired;
+
+}; // class rcu_domain
+
+} // namespace project
+
+#endif // __RCU_H__
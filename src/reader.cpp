@@ -0,0 +1,776 @@
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "reader.h"
+
+using namespace project;
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// cfg_mapping
+// read-only memory mapping of a whole cfg file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+cfg_mapping::~cfg_mapping() {
+  if (m_size > 0)
+    munmap((void *)m_data, m_size);
+}
+
+shared_ptr<cfg_mapping> cfg_mapping::open(const string &fn) {
+  int fd = ::open(fn.c_str(), O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+
+  shared_ptr<cfg_mapping> m(new cfg_mapping());
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return nullptr;
+  }
+  if (st.st_size > 0) {
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      close(fd);
+      return nullptr;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    m->m_data = (const char *)p;
+    m->m_size = st.st_size;
+  }
+  else
+    m->m_data = "";
+  close(fd);
+  return m;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// cfg_reader
+// streaming reader of libconfig file, memory is bounded by the read buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// initial size of read buffer, grows only if one token does not fit
+static const size_t s_read_chunk = 64 * 1024;
+
+cfg_reader::cfg_reader()
+    : m_mapped(false), m_defer_includes(false), m_n_threads(1), m_handler(nullptr),
+      m_has_peeked(false) {}
+
+cfg_reader::~cfg_reader() {
+  for (auto &s : m_sources)
+    if (s->m_fp)
+      fclose(s->m_fp);
+}
+
+void cfg_reader::read_file(const string &fn, cfg_handler &h) {
+  for (auto &s : m_sources)
+    if (s->m_fp)
+      fclose(s->m_fp);
+  m_sources.clear();
+  m_shards.clear();
+  m_shard_index.clear();
+  m_has_peeked = false;
+
+  m_handler = &h;
+  if (m_mapped && m_n_threads > 1)
+    load_shards(fn);
+  else
+    open(fn);
+  parse_settings(h, 0);
+}
+
+vector<string> cfg_reader::get_includes(const string &fn) {
+  vector<string> incs;
+  collect_includes(fn, 0, incs);
+  return incs;
+}
+
+// scan file with a reader of its own, comments and directives are lexed and
+// strings skipped as in read_file, so that only real directives are
+// collected. Other tokens are skipped up to the next character that may start
+// one of them
+void cfg_reader::collect_includes(const string &fn, int depth,
+                                  vector<string> &incs) {
+  // same limit as libconfig
+  if (depth > 10)
+    throw cfg_parse_error(fn, 0, "include too deeply nested");
+  cfg_reader r;
+  r.m_mapped = true;
+  r.m_defer_includes = true;
+  r.m_include_dir = m_include_dir;
+  r.open(fn);
+  source &s = *r.m_sources.back();
+  // most files have no directive at all, don't tokenize them
+  if (!memchr(s.m_data, '@', s.m_len))
+    return;
+  token t;
+  for (;;) {
+    r.skip_space();
+    int c = r.peek_char();
+    if (c == EOF)
+      break;
+    if (c == '"') {
+      // escapes as in lex_string, the text itself is not needed
+      for (++s.m_pos; s.m_pos < s.m_len && s.m_data[s.m_pos] != '"'; ++s.m_pos) {
+        if (s.m_data[s.m_pos] == '\\')
+          ++s.m_pos;
+        else if (s.m_data[s.m_pos] == '\n')
+          ++s.m_line;
+      }
+      if (s.m_pos >= s.m_len)
+        r.fail("unterminated string");
+      ++s.m_pos;
+    }
+    else if (c == '@') {
+      r.lex(t);
+      incs.emplace_back(t.m_text);
+      collect_includes(incs.back(), depth + 1, incs);
+    }
+    else
+      for (++s.m_pos; s.m_pos < s.m_len && !strchr(" \t\r\n\"@#/", s.m_data[s.m_pos]);)
+        ++s.m_pos;
+  }
+}
+
+vector<cfg_reader::shard_stat> cfg_reader::get_shard_stats() const {
+  vector<shard_stat> stats;
+  for (const auto &sh : m_shards)
+    stats.push_back({ sh->m_file, sh->m_tokens.size(), sh->m_ms });
+  return stats;
+}
+
+// tokenize a whole mapped file with a reader of its own, safe to run on any
+// thread, errors are kept in the shard and thrown when it is parsed
+void cfg_reader::lex_shard(shard &sh) {
+  auto start = chrono::steady_clock::now();
+  cfg_reader r;
+  r.m_mapped = true;
+  r.m_defer_includes = true;
+  r.m_include_dir = m_include_dir;
+  try {
+    r.open(sh.m_file);
+    sh.m_map = r.m_sources.back()->m_map;
+    token t;
+    for (r.lex(t); t.m_type != enum_tok_eof; r.lex(t)) {
+      if (!sh.m_map->contains(t.m_text)) {
+        sh.m_texts.emplace_back(t.m_text);
+        t.m_text = sh.m_texts.back();
+      }
+      sh.m_tokens.push_back(t);
+    }
+  }
+  catch (...) {
+    sh.m_error = current_exception();
+  }
+  sh.m_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// tokenize the main file, then the files it includes on worker threads, the
+// tokens are parsed on this thread in file order
+void cfg_reader::load_shards(const string &fn) {
+  unique_ptr<shard> main(new shard());
+  main->m_file = fn;
+  lex_shard(*main);
+  if (main->m_error)
+    rethrow_exception(main->m_error);
+  m_shard_index[fn] = main.get();
+  m_shards.push_back(std::move(main));
+
+  for (const auto &t : m_shards[0]->m_tokens) {
+    if (t.m_type != enum_tok_include)
+      continue;
+    string inc(t.m_text);
+    if (m_shard_index.count(inc))
+      continue;
+    unique_ptr<shard> sh(new shard());
+    sh->m_file = inc;
+    m_shard_index[inc] = sh.get();
+    m_shards.push_back(std::move(sh));
+  }
+
+  atomic<size_t> next(1);
+  vector<thread> workers;
+  size_t n = min((size_t)m_n_threads, m_shards.size() - 1);
+  for (size_t i = 0; i < n; ++i)
+    workers.emplace_back([this, &next] {
+      for (size_t j; (j = next++) < m_shards.size();)
+        lex_shard(*m_shards[j]);
+    });
+  for (auto &w : workers)
+    w.join();
+
+  open_shard(fn);
+}
+
+// push the tokens of a file, nested includes not seen by load_shards are
+// tokenized here
+void cfg_reader::open_shard(const string &fn) {
+  auto it = m_shard_index.find(fn);
+  shard *sh = (it != m_shard_index.end() ? it->second : nullptr);
+  if (!sh) {
+    unique_ptr<shard> p(new shard());
+    p->m_file = fn;
+    lex_shard(*p);
+    sh = p.get();
+    m_shard_index[fn] = sh;
+    m_shards.push_back(std::move(p));
+  }
+  if (sh->m_error) {
+    if (!sh->m_map && !m_sources.empty())
+      fail("failed to open include file " + fn);
+    rethrow_exception(sh->m_error);
+  }
+
+  unique_ptr<source> s(new source());
+  s->m_file = fn;
+  s->m_fp = nullptr;
+  s->m_map = sh->m_map;
+  s->m_shard = sh;
+  s->m_next = 0;
+  s->m_data = sh->m_map->data();
+  s->m_len = sh->m_map->size();
+  s->m_pos = 0;
+  s->m_mark = 0;
+  s->m_line = 1;
+  m_handler->on_mapping(sh->m_map);
+  m_sources.push_back(std::move(s));
+}
+
+void cfg_reader::open(const string &fn) {
+  FILE *fp = nullptr;
+  shared_ptr<cfg_mapping> m;
+  if (m_mapped)
+    m = cfg_mapping::open(fn);
+  else
+    fp = fopen(fn.c_str(), "rb");
+  if (!fp && !m) {
+    if (m_sources.empty())
+      throw cfg_parse_error(fn, 0, "failed to open file");
+    fail("failed to open include file " + fn);
+  }
+
+  unique_ptr<source> s(new source());
+  s->m_file = fn;
+  s->m_fp = fp;
+  s->m_map = m;
+  s->m_shard = nullptr;
+  s->m_next = 0;
+  if (m) {
+    s->m_data = m->data();
+    s->m_len = m->size();
+    if (m_handler)
+      m_handler->on_mapping(m);
+  }
+  else {
+    s->m_buf.resize(s_read_chunk);
+    s->m_data = s->m_buf.data();
+    s->m_len = 0;
+  }
+  s->m_pos = 0;
+  s->m_mark = 0;
+  s->m_line = 1;
+  m_sources.push_back(std::move(s));
+}
+
+// make sure n + 1 bytes are available from current position, bytes before the
+// mark are discarded when the window is refilled
+bool cfg_reader::fill(size_t n) {
+  source &s = *m_sources.back();
+  while (s.m_len - s.m_pos <= n) {
+    if (!s.m_fp)
+      return false;
+    if (s.m_mark > 0) {
+      memmove(s.m_buf.data(), s.m_buf.data() + s.m_mark, s.m_len - s.m_mark);
+      s.m_len -= s.m_mark;
+      s.m_pos -= s.m_mark;
+      s.m_mark = 0;
+    }
+    if (s.m_len == s.m_buf.size())
+      s.m_buf.resize(s.m_buf.size() * 2);
+    s.m_data = s.m_buf.data();
+    size_t n_read = fread(s.m_buf.data() + s.m_len, 1, s.m_buf.size() - s.m_len, s.m_fp);
+    if (n_read == 0) {
+      fclose(s.m_fp);
+      s.m_fp = nullptr;
+      return s.m_len - s.m_pos > n;
+    }
+    s.m_len += n_read;
+  }
+  return true;
+}
+
+int cfg_reader::peek_char(size_t n /* = 0 */) {
+  if (!fill(n))
+    return EOF;
+  source &s = *m_sources.back();
+  return (unsigned char)s.m_data[s.m_pos + n];
+}
+
+void cfg_reader::skip_space() {
+  source &s = *m_sources.back();
+  for (;;) {
+    int c = peek_char();
+    if (c == EOF)
+      return;
+    if (isspace(c)) {
+      if (c == '\n')
+        ++s.m_line;
+      ++s.m_pos;
+    }
+    else if (c == '#' || (c == '/' && peek_char(1) == '/')) {
+      while ((c = peek_char()) != EOF && c != '\n')
+        ++s.m_pos;
+    }
+    else if (c == '/' && peek_char(1) == '*') {
+      s.m_pos += 2;
+      while (!(peek_char() == '*' && peek_char(1) == '/')) {
+        if ((c = peek_char()) == EOF)
+          fail("unterminated comment");
+        if (c == '\n')
+          ++s.m_line;
+        ++s.m_pos;
+      }
+      s.m_pos += 2;
+    }
+    else
+      return;
+  }
+}
+
+void cfg_reader::lex(token &t) {
+  for (;;) {
+    source &s = *m_sources.back();
+    if (s.m_shard) {
+      if (s.m_next == s.m_shard->m_tokens.size()) {
+        if (m_sources.size() > 1) {
+          m_sources.pop_back();
+          continue;
+        }
+        t.m_type = enum_tok_eof;
+        return;
+      }
+      t = s.m_shard->m_tokens[s.m_next++];
+      s.m_line = t.m_line;
+      if (t.m_type == enum_tok_include) {
+        open_shard(string(t.m_text));
+        continue;
+      }
+      return;
+    }
+
+    s.m_mark = s.m_pos;
+    skip_space();
+    s.m_mark = s.m_pos;
+    t.m_line = s.m_line;
+
+    int c = peek_char();
+    if (c == EOF) {
+      // back to the including file
+      if (m_sources.size() > 1) {
+        m_sources.pop_back();
+        continue;
+      }
+      t.m_type = enum_tok_eof;
+      return;
+    }
+
+    if (c == '@') {
+      size_t n = 1;
+      while (isalpha(peek_char(n)))
+        ++n;
+      if (string(s.m_data + s.m_pos, n) != "@include")
+        fail("unknown directive");
+      s.m_pos += n;
+      skip_space();
+      s.m_mark = s.m_pos;
+      if (peek_char() != '"')
+        fail("file name expected after @include");
+      lex_string(t);
+      string fn(t.m_text);
+      if (!m_include_dir.empty() && (fn.empty() || fn[0] != '/'))
+        fn = m_include_dir + "/" + fn;
+      if (m_defer_includes) {
+        m_scratch = fn;
+        t.m_type = enum_tok_include;
+        t.m_text = string_view(m_scratch);
+        return;
+      }
+      open(fn);
+      continue;
+    }
+
+    if (c == '"') {
+      lex_string(t);
+      return;
+    }
+
+    if (isalpha(c) || c == '*') {
+      size_t n = 1;
+      for (int d = peek_char(n); d != EOF && (isalnum(d) || d == '_' || d == '-' || d == '*'); d = peek_char(++n))
+        ;
+      t.m_text = string_view(s.m_data + s.m_pos, n);
+      s.m_pos += n;
+      if (strncasecmp(t.m_text.data(), "true", n) == 0 && n == 4) {
+        t.m_type = enum_tok_value;
+        t.m_value_type = enum_cfg_bool;
+      }
+      else if (strncasecmp(t.m_text.data(), "false", n) == 0 && n == 5) {
+        t.m_type = enum_tok_value;
+        t.m_value_type = enum_cfg_bool;
+      }
+      else
+        t.m_type = enum_tok_name;
+      return;
+    }
+
+    if (isdigit(c) || c == '-' || c == '+' || c == '.') {
+      size_t n = 1;
+      bool hex = (c == '0' && tolower(peek_char(1)) == 'x');
+      bool real = (c == '.');
+      for (int d = peek_char(n); d != EOF; d = peek_char(++n)) {
+        int p = tolower(peek_char(n - 1));
+        if (isalnum(d) || d == '.')
+          real = real || (!hex && (d == '.' || tolower(d) == 'e'));
+        else if ((d == '-' || d == '+') && p == 'e' && !hex)
+          continue;
+        else
+          break;
+      }
+      t.m_type = enum_tok_value;
+      t.m_text = string_view(s.m_data + s.m_pos, n);
+      s.m_pos += n;
+      if (real)
+        t.m_value_type = enum_cfg_float;
+      else if (tolower(t.m_text.back()) == 'l')
+        t.m_value_type = enum_cfg_int64;
+      else {
+        long long v = strtoll(string(t.m_text).c_str(), nullptr, 0);
+        t.m_value_type = (v > INT32_MAX || v < INT32_MIN) ? enum_cfg_int64 : enum_cfg_int;
+      }
+      return;
+    }
+
+    if (strchr("=:;,{}[]()", c)) {
+      t.m_type = enum_tok_punct;
+      t.m_punct = (char)c;
+      t.m_text = string_view(s.m_data + s.m_pos, 1);
+      ++s.m_pos;
+      return;
+    }
+
+    fail(string("syntax error, unexpected character '") + (char)c + "'");
+  }
+}
+
+// string literal, adjacent literals are concatenated, the text refers to the
+// read buffer unless escapes or concatenation need the scratch buffer
+void cfg_reader::lex_string(token &t) {
+  source &s = *m_sources.back();
+  size_t begin = 0, end = 0;
+  bool scratch = false;
+  m_scratch.clear();
+  for (int n_literal = 0; peek_char() == '"'; ++n_literal) {
+    ++s.m_pos;
+    size_t lit_begin = s.m_pos - s.m_mark;
+    for (int c = peek_char(); c != '"'; c = peek_char()) {
+      if (c == EOF)
+        fail("unterminated string");
+      if (c == '\n')
+        ++s.m_line;
+      if (c == '\\') {
+        if (!scratch) {
+          m_scratch.assign(s.m_data + s.m_mark + begin, end - begin);
+          m_scratch.append(s.m_data + s.m_mark + lit_begin, s.m_pos - s.m_mark - lit_begin);
+          scratch = true;
+        }
+        int e = peek_char(1);
+        s.m_pos += 2;
+        switch (e) {
+          case 'n': m_scratch += '\n'; break;
+          case 'r': m_scratch += '\r'; break;
+          case 't': m_scratch += '\t'; break;
+          case 'f': m_scratch += '\f'; break;
+          case 'x': {
+            char hex[3] = { (char)peek_char(), (char)peek_char(1), 0 };
+            m_scratch += (char)strtol(hex, nullptr, 16);
+            s.m_pos += 2;
+            break;
+          }
+          case EOF: fail("unterminated string");
+          default: m_scratch += (char)e; break;
+        }
+        continue;
+      }
+      if (scratch)
+        m_scratch += (char)c;
+      ++s.m_pos;
+    }
+    if (n_literal == 0) {
+      begin = lit_begin;
+      end = s.m_pos - s.m_mark;
+    }
+    else if (!scratch) {
+      m_scratch.assign(s.m_data + s.m_mark + begin, end - begin);
+      m_scratch.append(s.m_data + s.m_mark + lit_begin, s.m_pos - s.m_mark - lit_begin);
+      scratch = true;
+    }
+    ++s.m_pos;
+    skip_space();
+  }
+  t.m_type = enum_tok_value;
+  t.m_value_type = enum_cfg_string;
+  if (scratch)
+    t.m_text = string_view(m_scratch);
+  else
+    t.m_text = string_view(s.m_data + s.m_mark + begin, end - begin);
+}
+
+void cfg_reader::next(token &t) {
+  if (m_has_peeked) {
+    t = m_peeked;
+    m_has_peeked = false;
+  }
+  else
+    lex(t);
+}
+
+void cfg_reader::peek(token &t) {
+  if (!m_has_peeked) {
+    lex(m_peeked);
+    m_has_peeked = true;
+  }
+  t = m_peeked;
+}
+
+void cfg_reader::parse_settings(cfg_handler &h, char close) {
+  token t;
+  for (;;) {
+    next(t);
+    if (t.m_type == enum_tok_eof) {
+      if (close)
+        fail("unexpected end of file");
+      return;
+    }
+    if (t.m_type == enum_tok_punct && t.m_punct == close)
+      return;
+    if (t.m_type != enum_tok_name)
+      fail("syntax error, setting name expected");
+
+    string name(t.m_text);
+    next(t);
+    if (t.m_type != enum_tok_punct || (t.m_punct != '=' && t.m_punct != ':'))
+      fail("syntax error, '=' expected after " + name);
+    next(t);
+    parse_value(h, name, t);
+
+    peek(t);
+    if (t.m_type == enum_tok_punct && (t.m_punct == ';' || t.m_punct == ','))
+      next(t);
+  }
+}
+
+void cfg_reader::parse_value(cfg_handler &h, string_view name, token &t) {
+  if (t.m_type == enum_tok_value) {
+    h.on_value(name, t.m_value_type, t.m_text);
+    return;
+  }
+  if (t.m_type != enum_tok_punct)
+    fail("syntax error, value expected");
+
+  if (t.m_punct == '{') {
+    h.on_begin(name, enum_cfg_group);
+    parse_settings(h, '}');
+    h.on_end(enum_cfg_group);
+  }
+  else if (t.m_punct == '[' || t.m_punct == '(') {
+    cfg_type_t type = (t.m_punct == '[' ? enum_cfg_array : enum_cfg_list);
+    char close = (t.m_punct == '[' ? ']' : ')');
+    h.on_begin(name, type);
+    for (;;) {
+      peek(t);
+      if (t.m_type == enum_tok_punct && t.m_punct == close) {
+        next(t);
+        break;
+      }
+      next(t);
+      parse_value(h, string_view(), t);
+      next(t);
+      if (t.m_type == enum_tok_punct && t.m_punct == close)
+        break;
+      if (t.m_type != enum_tok_punct || t.m_punct != ',')
+        fail("syntax error, ',' expected in list");
+    }
+    h.on_end(type);
+  }
+  else
+    fail("syntax error, value expected");
+}
+
+void cfg_reader::fail(const string &error) {
+  const source &s = *m_sources.back();
+  throw cfg_parse_error(s.m_file, s.m_line, error);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// cfg_tree
+// compact tree of settings, one vector of nodes linked by index
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void cfg_tree::clear() {
+  m_nodes.clear();
+  m_mappings.clear();
+  m_chunk = 0;
+  m_used = 0;
+  node root = { enum_cfg_group, string_view(), string_view(), -1, -1, -1, -1, 0 };
+  m_nodes.push_back(root);
+}
+
+string_view cfg_tree::store(string_view sv) {
+  if (sv.empty())
+    return string_view();
+  // most texts come from the file mapped last, e.g. the current include
+  for (auto m = m_mappings.rbegin(); m != m_mappings.rend(); ++m)
+    if ((*m)->contains(sv))
+      return sv;
+  while (m_chunk < m_chunks.size() && m_chunks[m_chunk].m_size - m_used < sv.size()) {
+    ++m_chunk;
+    m_used = 0;
+  }
+  if (m_chunk == m_chunks.size()) {
+    size_t n = max((size_t)enum_chunk_size, sv.size());
+    chunk c = { unique_ptr<char[]>(new char[n]), n };
+    m_chunks.push_back(std::move(c));
+    m_used = 0;
+  }
+  char *p = m_chunks[m_chunk].m_data.get() + m_used;
+  memcpy(p, sv.data(), sv.size());
+  m_used += sv.size();
+  return string_view(p, sv.size());
+}
+
+int cfg_tree::add(int parent, cfg_type_t type, string_view name, string_view text) {
+  int idx = (int)m_nodes.size();
+  node n = { type, store(name), store(text), parent, -1, -1, -1, 0 };
+  m_nodes.push_back(n);
+  node &p = m_nodes[parent];
+  if (p.m_last_child < 0)
+    p.m_first_child = idx;
+  else
+    m_nodes[p.m_last_child].m_next_sibling = idx;
+  p.m_last_child = idx;
+  ++p.m_length;
+  return idx;
+}
+
+int cfg_tree::child(int idx, string_view name) const {
+  for (int c = m_nodes[idx].m_first_child; c >= 0; c = m_nodes[c].m_next_sibling)
+    if (m_nodes[c].m_name == name)
+      return c;
+  return -1;
+}
+
+int cfg_tree::child(int idx, int i) const {
+  if (i < 0 || i >= m_nodes[idx].m_length)
+    return -1;
+  int c = m_nodes[idx].m_first_child;
+  while (i-- > 0)
+    c = m_nodes[c].m_next_sibling;
+  return c;
+}
+
+int cfg_tree::lookup(int idx, const string &path) const {
+  size_t prev = 0, pos = 0;
+  while (idx >= 0 && prev <= path.size()) {
+    pos = path.find_first_of(".:/", prev);
+    if (pos == string::npos)
+      pos = path.size();
+    string_view tok(path.data() + prev, pos - prev);
+    prev = pos + 1;
+    if (tok.empty())
+      continue;
+    if (tok[0] == '[') {
+      if (m_nodes[idx].m_type < enum_cfg_group)
+        return -1;
+      idx = child(idx, atoi(tok.data() + 1));
+    }
+    else {
+      if (m_nodes[idx].m_type != enum_cfg_group)
+        return -1;
+      idx = child(idx, tok);
+    }
+  }
+  return idx;
+}
+
+string cfg_tree::get_path(int idx) const {
+  string path;
+  for (; idx > 0; idx = m_nodes[idx].m_parent) {
+    const node &n = m_nodes[idx];
+    string seg;
+    if (n.m_name.empty()) {
+      int i = 0;
+      for (int c = m_nodes[n.m_parent].m_first_child; c != idx; c = m_nodes[c].m_next_sibling)
+        ++i;
+      seg = "[" + to_string(i) + "]";
+    }
+    else
+      seg = string(n.m_name);
+    path = path.empty() ? seg : seg + "." + path;
+  }
+  return path;
+}
+
+// no conversion between number types, same as libconfig settings
+long long cfg_tree::get_integer(int idx) const {
+  const node &n = m_nodes[idx];
+  if (n.m_type != enum_cfg_int && n.m_type != enum_cfg_int64)
+    throw runtime_error("type mismatch, " + get_path(idx));
+  return strtoll(string(n.m_text).c_str(), nullptr, 0);
+}
+
+void cfg_tree::get(int idx, bool &val) const {
+  const node &n = m_nodes[idx];
+  if (n.m_type != enum_cfg_bool)
+    throw runtime_error("type mismatch, " + get_path(idx));
+  val = (tolower(n.m_text[0]) == 't');
+}
+
+void cfg_tree::get(int idx, int &val) const { val = (int)get_integer(idx); }
+
+void cfg_tree::get(int idx, long &val) const { val = (long)get_integer(idx); }
+
+void cfg_tree::get(int idx, unsigned &val) const { val = (unsigned)get_integer(idx); }
+
+void cfg_tree::get(int idx, double &val) const {
+  const node &n = m_nodes[idx];
+  if (n.m_type != enum_cfg_float)
+    throw runtime_error("type mismatch, " + get_path(idx));
+  val = strtod(string(n.m_text).c_str(), nullptr);
+}
+
+void cfg_tree::get(int idx, string &val) const {
+  const node &n = m_nodes[idx];
+  if (n.m_type != enum_cfg_string)
+    throw runtime_error("type mismatch, " + get_path(idx));
+  val.assign(n.m_text.data(), n.m_text.size());
+}
+
+} // namespace project
@@ -0,0 +1,311 @@
+#ifndef __READER_H__
+#define __READER_H__
+
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace project {
+
+// type of value in libconfig grammar, same order as libconfig::Setting::Type
+enum cfg_type_t {
+  enum_cfg_none,
+  enum_cfg_int,
+  enum_cfg_int64,
+  enum_cfg_float,
+  enum_cfg_string,
+  enum_cfg_bool,
+  enum_cfg_group,
+  enum_cfg_array,
+  enum_cfg_list
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// cfg_parse_error
+// exception of syntax error found by cfg_reader
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class cfg_parse_error : public runtime_error {
+public:
+  cfg_parse_error(const string &file, int line, const string &error)
+      : runtime_error(error), m_file(file), m_line(line) {}
+
+  const string &get_file() const { return m_file; }
+  int get_line() const { return m_line; }
+
+private:
+  string m_file;
+  int m_line;
+
+}; // class cfg_parse_error
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// cfg_mapping
+// read-only memory mapping of a whole cfg file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class cfg_mapping {
+public:
+  ~cfg_mapping();
+
+  // return nullptr if the file can not be opened or mapped
+  static shared_ptr<cfg_mapping> open(const string &);
+
+  const char *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool contains(string_view sv) const {
+    return sv.data() >= m_data && sv.data() + sv.size() <= m_data + m_size;
+  }
+
+private:
+  cfg_mapping() : m_data(nullptr), m_size(0) {}
+  cfg_mapping(const cfg_mapping &) = delete;
+  cfg_mapping &operator=(const cfg_mapping &) = delete;
+
+  const char *m_data;
+  size_t m_size;
+
+}; // class cfg_mapping
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// cfg_handler
+// receiver of the events emitted by cfg_reader, SAX style
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class cfg_handler {
+public:
+  virtual ~cfg_handler() {}
+
+  // name is empty for the elements of list and array
+  // NOTE: the name and text views are only valid during the call
+  virtual void on_begin(string_view name, cfg_type_t type) = 0;
+  virtual void on_end(cfg_type_t type) = 0;
+  virtual void on_value(string_view name, cfg_type_t type, string_view text) = 0;
+
+  // file is mapped, views into it stay valid while the mapping is referenced
+  virtual void on_mapping(const shared_ptr<cfg_mapping> &) {}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// cfg_reader
+// streaming reader of libconfig file, memory is bounded by the read buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class cfg_reader {
+public:
+  cfg_reader();
+  ~cfg_reader();
+
+  void set_include_dir(const string &dir) { m_include_dir = dir; }
+
+  // mmap files instead of reading them, tokens without escapes then refer to
+  // the mapping, see cfg_handler::on_mapping
+  void set_mapped(bool mapped) { m_mapped = mapped; }
+
+  // with mapped files, tokenize the files included by the main file on n
+  // threads before parsing, e.g. one include per site
+  void set_shards(unsigned n) { m_n_threads = n; }
+
+  // read file and emit events to handler, throw cfg_parse_error
+  void read_file(const string &, cfg_handler &);
+
+  // paths of the files included by file and by them, in include order and
+  // resolved like read_file does, throw cfg_parse_error
+  vector<string> get_includes(const string &);
+
+  // tokenizing time of each file of the last sharded read, main file first
+  struct shard_stat {
+    string m_file;
+    size_t m_n_tokens;
+    double m_ms;
+  };
+  vector<shard_stat> get_shard_stats() const;
+
+private:
+  enum token_t {
+    enum_tok_eof,
+    enum_tok_name,
+    enum_tok_value,
+    enum_tok_punct,
+    enum_tok_include
+  };
+
+  struct token {
+    token_t m_type;
+    cfg_type_t m_value_type;
+    char m_punct;
+    string_view m_text;
+    int m_line;
+  };
+
+  // tokens of a whole file, includes are kept as tokens with the file path
+  struct shard {
+    string m_file;
+    shared_ptr<cfg_mapping> m_map;
+    vector<token> m_tokens;
+    deque<string> m_texts; // texts not in the mapping
+    double m_ms;
+    exception_ptr m_error;
+  };
+
+  // one opened file, the window [m_data, m_data + m_len) is refilled from
+  // m_fp with bytes before m_mark discarded, or covers the whole mapping
+  struct source {
+    string m_file;
+    FILE *m_fp;
+    shared_ptr<cfg_mapping> m_map;
+    const shard *m_shard; // replayed from tokens if not null
+    size_t m_next;
+    vector<char> m_buf;
+    const char *m_data;
+    size_t m_len;
+    size_t m_pos;
+    size_t m_mark;
+    int m_line;
+  };
+
+  void open(const string &);
+  void collect_includes(const string &, int, vector<string> &);
+  void lex_shard(shard &);
+  void load_shards(const string &);
+  void open_shard(const string &);
+  bool fill(size_t);
+  int peek_char(size_t = 0);
+  void skip_space();
+  void lex(token &);
+  void lex_string(token &);
+  void next(token &);
+  void peek(token &);
+
+  void parse_settings(cfg_handler &, char);
+  void parse_value(cfg_handler &, string_view, token &);
+
+  [[noreturn]] void fail(const string &);
+
+  string m_include_dir;
+  bool m_mapped;
+  bool m_defer_includes;
+  unsigned m_n_threads;
+  cfg_handler *m_handler;
+  vector<unique_ptr<source>> m_sources;
+  vector<unique_ptr<shard>> m_shards;
+  map<string, shard *> m_shard_index;
+  string m_scratch;
+  token m_peeked;
+  bool m_has_peeked;
+
+}; // class cfg_reader
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// cfg_tree
+// compact tree of settings, one vector of nodes linked by index
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class cfg_tree {
+public:
+  struct node {
+    cfg_type_t m_type;
+    string_view m_name;
+    string_view m_text;
+    int m_parent;
+    int m_first_child;
+    int m_last_child;
+    int m_next_sibling;
+    int m_length;
+  };
+
+  // root group is node 0
+  cfg_tree() { clear(); }
+
+  void clear();
+  size_t size() const { return m_nodes.size(); }
+  const node &at(int idx) const { return m_nodes[idx]; }
+
+  // add node under parent, name and text are copied into the tree unless
+  // they refer to a kept mapping
+  int add(int, cfg_type_t, string_view, string_view);
+  void keep(const shared_ptr<cfg_mapping> &m) { m_mappings.push_back(m); }
+
+  // find node by libconfig path, e.g. tls.dns_cache or groups.[0].type,
+  // return -1 if not found
+  int lookup(int, const string &) const;
+  int child(int, string_view) const;
+  int child(int, int) const;
+  int get_length(int idx) const { return m_nodes[idx].m_length; }
+  string get_path(int) const;
+
+  // typed value, throw runtime_error if the node type does not match, numbers
+  // are not converted between int and float, as by libconfig
+  void get(int, bool &) const;
+  void get(int, int &) const;
+  void get(int, long &) const;
+  void get(int, unsigned &) const;
+  void get(int, double &) const;
+  void get(int, string &) const;
+
+private:
+  long long get_integer(int) const;
+  string_view store(string_view);
+
+  // arena of copied names and texts, kept across clear() for reuse
+  enum { enum_chunk_size = 4096 };
+  struct chunk {
+    unique_ptr<char[]> m_data;
+    size_t m_size;
+  };
+
+  vector<node> m_nodes;
+  vector<shared_ptr<cfg_mapping>> m_mappings;
+  vector<chunk> m_chunks;
+  size_t m_chunk;
+  size_t m_used;
+
+}; // class cfg_tree
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// cfg_tree_builder
+// handler of cfg_reader events building the whole file into a cfg_tree
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class cfg_tree_builder : public cfg_handler {
+public:
+  cfg_tree_builder(cfg_tree &tr) : m_tree(tr) { m_nodes.push_back(0); }
+
+  virtual void on_begin(string_view name, cfg_type_t type) {
+    m_nodes.push_back(m_tree.add(m_nodes.back(), type, name, string_view()));
+  }
+  virtual void on_end(cfg_type_t) { m_nodes.pop_back(); }
+  virtual void on_value(string_view name, cfg_type_t type, string_view text) {
+    m_tree.add(m_nodes.back(), type, name, text);
+  }
+  virtual void on_mapping(const shared_ptr<cfg_mapping> &m) { m_tree.keep(m); }
+
+private:
+  cfg_tree &m_tree;
+  vector<int> m_nodes;
+
+}; // class cfg_tree_builder
+
+} // namespace project
+
+#endif // __READER_H__
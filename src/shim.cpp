@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <memory>
 
@@ -17,7 +19,32 @@ namespace project {
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+// writes one member of dump, the value is borrowed from the object
+struct dump_visitor {
+    ostream &os;
+
+    void operator()(monostate) { os << "(un-handled type)"; }
+    void operator()(const bool *v) { os << boolalpha << *v; }
+    template <typename T> void operator()(const T *v) { os << *v; }
+    void operator()(const list<int> *v) { list_of(*v); }
+    void operator()(const list<string> *v) { list_of(*v); }
+    void operator()(const channel_set *v) { list_of(*v); }
+    void operator()(const string_vector *v) { list_of(*v); }
+
+    template <typename C> void list_of(const C &vs)
+    {
+        os << "[" << endl
+            << "    ";
+        for (typename C::const_iterator cit = vs.begin();
+                cit != vs.end(); ++cit)
+            os << (cit == vs.begin() ? "" : ", ") << *cit;
+        os << (vs.empty() ? "(empty)" : "") << endl
+            << "  ]";
+    }
+};
+
 void object_config::dump(ostream &os /* = std::cout */) {
+    materialize_all();
     if (is_site(m_map_id))
         os << "site_config#" << m_obj_id;
     else if (is_building(m_map_id))
@@ -28,63 +55,15 @@ void object_config::dump(ostream &os /* = std::cout */) {
     os << ", " << get_key() << endl
         << "  ver = " << get_ver() << endl;
 
-    for (auto b : m_members)
+    for (const auto &f : get_meta_info())
     {
-        // get var value via xetter
-        std::any v;
-        const member_t &m = b.second;
-        m.m_xetter->get(m.m_var, v);
+        // borrow var via xetter
+        member_t m = get_member(f.second);
+        var_cref v = m.m_xetter->ref(m.m_var);
         // output var
-        os << "  " << b.first
+        os << "  " << f.first
             << " = ";
-        if (v.type() == typeid(int8_t))
-            os << (int)std::any_cast<int8_t>(v);
-        else if (v.type() == typeid(int16_t))
-            os << std::any_cast<int16_t>(v);
-        else if (v.type() == typeid(int32_t))
-            os << std::any_cast<int32_t>(v);
-        else if (v.type() == typeid(int64_t))
-            os << std::any_cast<int64_t>(v);
-        else if (v.type() == typeid(uint8_t))
-            os << (int)std::any_cast<uint8_t>(v);
-        else if (v.type() == typeid(uint16_t))
-            os << std::any_cast<uint16_t>(v);
-        else if (v.type() == typeid(uint32_t))
-            os << std::any_cast<uint32_t>(v);
-        else if (v.type() == typeid(uint64_t))
-            os << std::any_cast<uint64_t>(v);
-        else if (v.type() == typeid(string))
-            os << std::any_cast<string>(v);
-        else if (v.type() == typeid(char *))
-            os << std::any_cast<char *>(v);
-        else if (v.type() == typeid(bool))
-            os << boolalpha << std::any_cast<bool>(v);
-        else if (v.type() == typeid(double))
-            os << std::any_cast<double>(v);
-        else if (v.type() == typeid(list<int>))
-        {
-            os << "[" << endl
-                << "    ";
-            const list<int> &vs = std::any_cast<list<int>>(v);
-            for (list<int>::const_iterator cit = vs.cbegin();
-                    cit != vs.cend(); ++cit)
-                os << (cit == vs.cbegin() ? "" : ", ") << *cit;
-            os << (vs.empty() ? "(empty)" : "") << endl
-                << "  ]";
-        }
-        else if (v.type() == typeid(list<string>))
-        {
-            os << "[" << endl
-                << "    ";
-            const list<string> &vs = std::any_cast<list<string>>(v);
-            for (list<string>::const_iterator cit = vs.cbegin();
-                    cit != vs.cend(); ++cit)
-                os << (cit == vs.cbegin() ? "" : ", ") << *cit;
-            os << (vs.empty() ? "(empty)" : "") << endl
-                << "  ]";
-        }
-        else
-            os << "(un-handled type)";
+        std::visit(dump_visitor{ os }, v);
         os << endl;
     }
 }
@@ -120,11 +99,17 @@ object_config_ptr object_config::create_ap_config(int ver) {
         return nullptr;
 }
 
-bool object_config::set(const string &var, const std::any &val) {
+bool object_config::set(const string &var, const var_value &val) {
   try {
-    if (m_members.find(var) != m_members.end()) {
-      member_t &b = m_members[var];
+    check_writable(var.c_str());
+    meta_map &mm = get_meta_info();
+    auto it = mm.find(var);
+    if (it != mm.end()) {
+      member_t b = get_member(it->second);
       b.m_xetter->set(b.m_var, val);
+      if (m_lazy)
+        settle(var.c_str());
+      notify(var.c_str(), enum_change_update);
       return true;
     }
     else 
@@ -135,10 +120,35 @@ bool object_config::set(const string &var, const std::any &val) {
   }
 }
 
-bool object_config::get(const string &var, std::any &val) {
+bool object_config::set(const string &var, var_value &&val) {
   try {
-    if (m_members.find(var) != m_members.end()) {
-      member_t &b = m_members[var];
+    check_writable(var.c_str());
+    meta_map &mm = get_meta_info();
+    auto it = mm.find(var);
+    if (it != mm.end()) {
+      member_t b = get_member(it->second);
+      b.m_xetter->set(b.m_var, std::move(val));
+      if (m_lazy)
+        settle(var.c_str());
+      notify(var.c_str(), enum_change_update);
+      return true;
+    }
+    else 
+      return false;
+  } catch (const exception &e) {
+    cerr << e.what() << endl;
+      return false;
+  }
+}
+
+bool object_config::get(const string &var, var_value &val) {
+  try {
+    if (m_lazy)
+      materialize(var.c_str());
+    meta_map &mm = get_meta_info();
+    auto it = mm.find(var);
+    if (it != mm.end()) {
+      member_t b = get_member(it->second);
       b.m_xetter->get(b.m_var, val);
       return true;
     }
@@ -150,6 +160,80 @@ bool object_config::get(const string &var, std::any &val) {
   }
 }
 
+bool object_config::get_ref(const string &var, var_cref &val) {
+  try {
+    if (m_lazy)
+      materialize(var.c_str());
+    meta_map &mm = get_meta_info();
+    auto it = mm.find(var);
+    if (it != mm.end()) {
+      member_t b = get_member(it->second);
+      val = b.m_xetter->ref(b.m_var);
+      return true;
+    }
+    else 
+      return false;
+  } catch (const exception &e) {
+    cerr << e.what() << endl;
+      return false;
+  }
+}
+
+// field ids follow the order of meta map, so that tables built by iterating
+// the map, e.g. decoders, can be indexed by field id
+void object_config::number_fields(meta_map &mm) {
+  int id = 0;
+  for (auto &m : mm)
+    m.second.m_field = id++;
+}
+
+void object_config::set_lazy(const shared_ptr<lazy_source> &src) {
+  m_lazy = src;
+  if (src != nullptr)
+    m_pending.fill(get_meta_info().size());
+  else
+    m_pending.clear();
+  if (m_pending.none())
+    m_lazy.reset();
+}
+
+const meta_t *object_config::find_meta(const char *var) {
+  meta_map &mm = get_meta_info();
+  auto it = mm.find(var);
+  return it == mm.end() ? nullptr : &it->second;
+}
+
+// decode one pending member, the source is released with the last one. The
+// member stays pending if decoding throws, so that every access reports it
+void object_config::materialize(const meta_t *m) {
+  if (!m || !m_pending.test(m->m_field))
+    return;
+  m_lazy->materialize(*m, get_member(*m));
+  m_pending.reset(m->m_field);
+  if (m_pending.none())
+    m_lazy.reset();
+}
+
+void object_config::materialize_all() {
+  if (!m_lazy)
+    return;
+  for (const auto &f : get_meta_info())
+    if (m_pending.test(f.second.m_field)) {
+      m_lazy->materialize(f.second, get_member(f.second));
+      m_pending.reset(f.second.m_field);
+    }
+  m_lazy.reset();
+}
+
+// member is assigned, it must not be decoded from the source any more
+void object_config::settle(const meta_t *m) {
+  if (!m || !m_pending.test(m->m_field))
+    return;
+  m_pending.reset(m->m_field);
+  if (m_pending.none())
+    m_lazy.reset();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // site_config
@@ -157,11 +241,9 @@ bool object_config::get(const string &var, std::any &val) {
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-int site_config::s_n_site = 0;
-
 site_config::site_config() {
-  m_obj_id = s_n_site++;
-  generate_map_id();
+  if (!is_id_deferred())
+    assign_id();
 
   // initialize optional
   m_ap_mode = 0;
@@ -175,6 +257,8 @@ site_config::site_config() {
   m_tls_debug = false;
 }
 
+void site_config::assign_id() { allocate_id(enum_id_site); }
+
 #if 0
 void site_config::dump(ostream &os /* = std::cout */) {
   os << "site_config#" << hex << m_obj_id << dec << ", " << m_name << endl
@@ -207,16 +291,16 @@ void site_config::dump(ostream &os /* = std::cout */) {
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-int building_config::s_n_building = 0;
-
 building_config::building_config() {
-  m_obj_id = s_n_building++;
-  generate_map_id();
+  if (!is_id_deferred())
+    assign_id();
   // initialize optional
   m_root_ca = "/";
   m_sas_crl = "/test.crl";
 }
 
+void building_config::assign_id() { allocate_id(enum_id_building); }
+
 #if 0
 void building_config::dump(ostream &os /* = std::cout */) {
   os << "building_config#" << hex << m_obj_id << dec << ", " << m_name << endl
@@ -242,11 +326,9 @@ void building_config::dump(ostream &os /* = std::cout */) {
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-int ap_config::s_n_ap = 0;
-
 ap_config::ap_config() {
-  m_obj_id = s_n_ap++;
-  generate_map_id();
+  if (!is_id_deferred())
+    assign_id();
   // initialize optional
   m_psi_enabled = true;
   m_psi_interval = 30;
@@ -254,6 +336,8 @@ ap_config::ap_config() {
   m_trans_expire_margin = 10;
 }
 
+void ap_config::assign_id() { allocate_id(enum_id_ap); }
+
 #if 0
 void ap_config::dump(ostream &os /* = std::cout */) {
   os << "ap_config#" << hex << m_obj_id << dec << ", " << m_name << endl
@@ -326,11 +410,9 @@ void ap_config::dump(ostream &os /* = std::cout */) {
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-int ap_config_v2::s_n_ap = 0;
-
 ap_config_v2::ap_config_v2() {
-    m_obj_id = s_n_ap++;
-    generate_map_id();
+    if (!is_id_deferred())
+        assign_id();
     // initialize optional
     m_psi_enabled = true;
     m_psi_interval = 30;
@@ -338,6 +420,8 @@ ap_config_v2::ap_config_v2() {
     m_trans_expire_margin = 10;
 }
 
+void ap_config_v2::assign_id() { allocate_id(enum_id_ap); }
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // app_config
@@ -346,8 +430,8 @@ ap_config_v2::ap_config_v2() {
 ///////////////////////////////////////////////////////////////////////////////
 
 app_config::app_config() {
-  m_obj_id = 0xfffful;
-  generate_map_id();
+  if (!is_id_deferred())
+    assign_id();
   // initialize optional
   m_thread_pool_size = 1;
   m_max_req_per_msg = 1;
@@ -358,6 +442,8 @@ app_config::app_config() {
   m_con_log_level = "debug";
 }
 
+void app_config::assign_id() { allocate_id(enum_id_app); }
+
 #if 0
 void app_config::dump(ostream &os /* = std::cout */) {
   os << "app_config#" << hex << m_obj_id << dec << ", " << get_key() << endl
@@ -378,6 +464,25 @@ void app_config::dump(ostream &os /* = std::cout */) {
 }
 #endif
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// shim_snapshot
+// immutable version of the store for concurrent readers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+static const object_config_ptr s_null_config;
+
+const object_config_ptr &shim_snapshot::find_config(const string &key) const {
+  int slot = m_store.find(key);
+  return slot >= 0 ? m_store.at(slot).m_val : s_null_config;
+}
+
+const object_config_ptr &shim_snapshot::find_config(uint64_t id) const {
+  int slot = m_store.find(id);
+  return slot >= 0 ? m_store.at(slot).m_val : s_null_config;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // shim
@@ -385,90 +490,621 @@ void app_config::dump(ostream &os /* = std::cout */) {
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-shim::shim() {}
+shim::shim() : m_snap(new shim_snapshot()) {}
 
-shim::~shim() {}
+shim::~shim() { delete m_snap.load(); }
+
+void shim::set_concurrent(bool concurrent) {
+  m_concurrent = concurrent;
+  if (!concurrent)
+    for (const auto &oc : m_store.ordered())
+      oc->m_published = false;
+}
+
+void shim::publish() {
+  if (!m_concurrent)
+    return;
+  shim_snapshot *next = new shim_snapshot();
+  const shim_snapshot *prev = m_snap.load();
+  next->m_version = prev->m_version + 1;
+  next->m_store = m_store;
+  for (const auto &oc : m_store.ordered()) {
+    oc->materialize_all();
+    oc->m_published = true;
+  }
+
+  m_snap.store(next, memory_order_release);
+  m_rcu.retire(const_cast<shim_snapshot *>(prev), [](void *p) {
+    delete static_cast<shim_snapshot *>(p);
+  });
+}
 
 void shim::initialize() { subscribe(this); }
 
 int shim::insert_config(object_config_ptr cfg) {
-  delete_config(cfg->get_key());
+  string key = cfg->get_key();
+  object_config_ptr old = nullptr;
+  uint64_t id = cfg->get_map_id();
+  int slot = m_store.find(key);
+  if (slot >= 0) {
+    // replace in place, the object keeps the position of the old one
+    old = m_store.at(slot).m_val;
+    uint64_t old_id = m_store.at(slot).m_id;
+    m_store.replace(slot, id, cfg);
+    unindex_config(old_id);
+    notify("m_store", enum_change_delete, reinterpret_cast<void *>(old_id));
+  }
+  else
+    m_store.insert(key, id, cfg);
 
   cfg->subscribe(this);
-  uint64_t id = cfg->get_map_id();
-  string key = cfg->get_key();
-  m_store[key] = cfg;
-  m_id2key[id] = key;
-  ordered_oc.push_back(cfg);
+  link(key, cfg, old);
+  index_config(cfg);
   notify("m_store", enum_change_add, reinterpret_cast<void *>(id));
   return 0;
 }
 
 int shim::delete_config(const string &key) {
-  object_config_ptr cfg = find_config(key);
-  if (cfg != nullptr) {
-    uint64_t id = cfg->get_map_id();
-    m_store.erase(key);
-    notify("m_store", enum_change_delete, reinterpret_cast<void *>(id));
-    m_id2key.erase(id);
-    return 1;
-  } else
+  int slot = m_store.find(key);
+  if (slot < 0)
     return 0;
+  uint64_t id = m_store.at(slot).m_id;
+  unlink(key, m_store.at(slot).m_val);
+  unindex_config(id);
+  m_store.erase(slot);
+  notify("m_store", enum_change_delete, reinterpret_cast<void *>(id));
+  return 1;
 }
 
 int shim::delete_config(uint64_t id) {
-  auto it = m_id2key.find(id);
-  if (it != m_id2key.end())
-    return delete_config(it->second);
-  else
+  int slot = m_store.find(id);
+  if (slot < 0)
     return 0;
+  return delete_config(m_store.at(slot).m_key);
 }
 
 object_config_ptr shim::find_config(const string &key) {
-  auto it = m_store.find(key);
-  if (it != m_store.end())
-    return it->second;
-  else
-    return nullptr;
+  int slot = m_store.find(key);
+  return slot >= 0 ? m_store.at(slot).m_val : nullptr;
 }
 
 object_config_ptr shim::find_config(uint64_t id) {
-  auto it = m_id2key.find(id);
-  if (it != m_id2key.end())
-    return find_config(it->second);
-  else
+  int slot = m_store.find(id);
+  return slot >= 0 ? m_store.at(slot).m_val : nullptr;
+}
+
+vector<object_config_ptr> shim::get_ordered_oc() const {
+  vector<object_config_ptr> ordered;
+  ordered.reserve(m_store.size());
+  for (const auto &oc : m_store.ordered())
+    ordered.push_back(oc);
+  return ordered;
+}
+
+vector<int> shim::sorted_slots() const {
+  vector<int> slots;
+  slots.reserve(m_store.size());
+  for (int i = 0; slots.size() < m_store.size(); ++i)
+    if (m_store.at(i).m_live)
+      slots.push_back(i);
+  sort(slots.begin(), slots.end(), [this](int a, int b) {
+    return m_store.at(a).m_key < m_store.at(b).m_key;
+  });
+  return slots;
+}
+
+map<uint64_t, string> shim::get_id_key() {
+  map<uint64_t, string> id_key;
+  m_store.for_each([&id_key](const store_index<object_config_ptr>::entry &e) {
+    id_key[e.m_id] = e.m_key;
+  });
+  return id_key;
+}
+
+map<string, object_config_ptr> shim::get_key_obj() {
+  map<string, object_config_ptr> key_obj;
+  m_store.for_each([&key_obj](const store_index<object_config_ptr>::entry &e) {
+    key_obj[e.m_key] = e.m_val;
+  });
+  return key_obj;
+}
+
+// key of building of ap or site of building, empty for site
+string shim::parent_key(const object_config_ptr &cfg) {
+  object_config *o = cfg.get();
+  if (auto tc = dynamic_cast<building_config *>(o))
+    return tc->get_site_name();
+  if (auto cc = dynamic_cast<ap_config *>(o))
+    return cc->get_building_name();
+  if (auto cc = dynamic_cast<ap_config_v2 *>(o))
+    return cc->get_building_name();
+  return string();
+}
+
+// add cfg under its parent, in place of old if old has the same parent
+void shim::link(const string &key, const object_config_ptr &cfg,
+                const object_config_ptr &old) {
+  node_t &n = m_nodes[key];
+  string parent = parent_key(cfg);
+  if (old && n.m_parent != parent)
+    unlink(key, old);
+  node_t &m = m_nodes[key];
+  m.m_obj = cfg;
+  if (parent.empty())
+    return;
+
+  vector<object_config_ptr> &siblings = m_nodes[parent].m_children;
+  if (old && m.m_parent == parent) {
+    size_t pos = child_pos(siblings, m.m_pos, old);
+    if (pos < siblings.size()) {
+      siblings[pos] = cfg;
+      m.m_pos = pos;
+      return;
+    }
+  }
+  m.m_parent = parent;
+  m.m_pos = siblings.size();
+  siblings.push_back(cfg);
+}
+
+// position of c, siblings only move to lower positions, so search down from
+// the last known position
+size_t shim::child_pos(const vector<object_config_ptr> &siblings, size_t pos,
+                       const object_config_ptr &c) {
+  for (size_t i = min(pos + 1, siblings.size()); i-- > 0;)
+    if (siblings[i] == c)
+      return i;
+  return siblings.size();
+}
+
+// remove cfg from its parent, nodes without object and children are dropped
+void shim::unlink(const string &key, const object_config_ptr &cfg) {
+  auto it = m_nodes.find(key);
+  if (it == m_nodes.end())
+    return;
+  string parent = it->second.m_parent;
+  size_t pos = it->second.m_pos;
+  it->second.m_parent.clear();
+  if (it->second.m_obj == cfg)
+    it->second.m_obj = nullptr;
+  if (!it->second.m_obj && it->second.m_children.empty())
+    m_nodes.erase(it);
+  if (parent.empty())
+    return;
+
+  auto p = m_nodes.find(parent);
+  if (p == m_nodes.end())
+    return;
+  vector<object_config_ptr> &siblings = p->second.m_children;
+  size_t c = child_pos(siblings, pos, cfg);
+  if (c < siblings.size())
+    siblings.erase(siblings.begin() + c);
+  if (!p->second.m_obj && siblings.empty())
+    m_nodes.erase(p);
+}
+
+object_config_ptr shim::find_parent(const string &key) const {
+  auto it = m_nodes.find(key);
+  if (it == m_nodes.end() || it->second.m_parent.empty())
     return nullptr;
+  auto p = m_nodes.find(it->second.m_parent);
+  return p != m_nodes.end() ? p->second.m_obj : nullptr;
+}
+
+span_view<object_config_ptr> shim::find_children(const string &key) const {
+  auto it = m_nodes.find(key);
+  if (it == m_nodes.end())
+    return span_view<object_config_ptr>(nullptr, 0);
+  const vector<object_config_ptr> &c = it->second.m_children;
+  return span_view<object_config_ptr>(c.data(), c.size());
+}
+
+// text of scalar field, false if the object has no such field or the field
+// is a list
+bool shim::field_text(const object_config_ptr &cfg, const string &field,
+                      string &text) {
+  var_cref v;
+  if (!cfg->get_ref(field, v))
+    return false;
+  if (const string *p = var_get<string>(v))
+    text = *p;
+  else if (const bool *p = var_get<bool>(v))
+    text = *p ? "true" : "false";
+  else if (const int *p = var_get<int>(v))
+    text = to_string(*p);
+  else if (const unsigned *p = var_get<unsigned>(v))
+    text = to_string(*p);
+  else if (const long *p = var_get<long>(v))
+    text = to_string(*p);
+  else if (const uint64_t *p = var_get<uint64_t>(v))
+    text = to_string(*p);
+  else if (const double *p = var_get<double>(v))
+    text = to_string(*p);
+  else
+    return false;
+  return true;
+}
+
+// latitude and longitude of ap, false if it has none
+bool shim::field_point(const object_config_ptr &cfg, double &lat, double &lon) {
+  var_cref a, b;
+  if (!cfg->get_ref("latitude", a) || !cfg->get_ref("longitude", b))
+    return false;
+  const double *pa = var_get<double>(a), *pb = var_get<double>(b);
+  if (!pa || !pb)
+    return false;
+  lat = *pa;
+  lon = *pb;
+  return true;
+}
+
+// band of ap in kHz
+template <typename A> static void band_of(A *ap, uint64_t &lo, uint64_t &hi) {
+  uint64_t center = ap->get_central_freq_khz();
+  uint64_t half = (uint64_t)ap->get_radio_bandwidth_mhz() * 500;
+  lo = center > half ? center - half : 0;
+  hi = center + half;
+}
+
+template <typename A> static uint64_t blacklist_of(A *ap) {
+  return ap->get_channel_blacklist().mask();
+}
+
+// false if object is not an ap
+bool shim::field_band(const object_config_ptr &cfg, uint64_t &lo, uint64_t &hi) {
+  if (ap_config *ap = dynamic_cast<ap_config *>(cfg.get()))
+    band_of(ap, lo, hi);
+  else if (ap_config_v2 *ap = dynamic_cast<ap_config_v2 *>(cfg.get()))
+    band_of(ap, lo, hi);
+  else
+    return false;
+  return true;
+}
+
+// mask of cbrs channels in channel_blacklist of ap
+uint64_t shim::blacklist_mask(const object_config_ptr &cfg) {
+  if (ap_config *ap = dynamic_cast<ap_config *>(cfg.get()))
+    return blacklist_of(ap);
+  if (ap_config_v2 *ap = dynamic_cast<ap_config_v2 *>(cfg.get()))
+    return blacklist_of(ap);
+  return 0;
+}
+
+// copy field of ap into its row, lazy aps decode the field first
+void shim::column_field(const object_config_ptr &cfg, uint32_t slot,
+                        const string &field, column_base &c) {
+  meta_map &mm = cfg->get_meta_info();
+  auto m = mm.find(field);
+  if (m == mm.end() || m->second.m_vtype != c.get_vtype())
+    return;
+  if (cfg->is_lazy())
+    cfg->materialize(field.c_str());
+  c.set(slot, cfg->get_member(m->second).m_var);
+}
+
+// row of ap in the column store
+void shim::column_config(const object_config_ptr &cfg) {
+  uint32_t slot = m_columns->insert(cfg->get_map_id());
+  m_columns->for_each_column([&](const string &field, column_base &c) {
+    column_field(cfg, slot, field, c);
+  });
+}
+
+void shim::index_config(const object_config_ptr &cfg) {
+  uint64_t id = cfg->get_map_id();
+  if ((m_indexes.empty() && !m_grid && !m_bands && !m_columns)
+      || !object_config::is_ap(id))
+    return;
+  string text;
+  for (auto &ix : m_indexes)
+    if (field_text(cfg, ix.first, text))
+      ix.second.insert(id, text);
+  double lat, lon;
+  if (m_grid && field_point(cfg, lat, lon))
+    m_grid->insert(id, lat, lon);
+  uint64_t lo, hi;
+  if (m_bands && field_band(cfg, lo, hi))
+    m_bands->insert(id, lo, hi);
+  if (m_columns)
+    column_config(cfg);
+}
+
+void shim::unindex_config(uint64_t id) {
+  for (auto &ix : m_indexes)
+    ix.second.erase(id);
+  if (m_grid)
+    m_grid->erase(id);
+  if (m_bands)
+    m_bands->erase(id);
+  if (m_columns)
+    m_columns->erase(id);
+}
+
+bool shim::create_index(const string &field) {
+  if (m_indexes.count(field))
+    return false;
+  value_index &ix = m_indexes[field];
+  string text;
+  for_each_ap([&](const object_config_ptr &cfg) {
+    if (field_text(cfg, field, text))
+      ix.insert(cfg->get_map_id(), text);
+  });
+  return true;
+}
+
+void shim::drop_index(const string &field) { m_indexes.erase(field); }
+
+bool shim::create_spatial_index(double cell_deg /* = 0.01 */) {
+  if (m_grid || !(cell_deg > 0))
+    return false;
+  m_grid.reset(new grid_index(cell_deg));
+  double lat, lon;
+  for_each_ap([&](const object_config_ptr &cfg) {
+    if (field_point(cfg, lat, lon))
+      m_grid->insert(cfg->get_map_id(), lat, lon);
+  });
+  return true;
+}
+
+bool shim::create_band_index() {
+  if (m_bands)
+    return false;
+  m_bands.reset(new interval_index());
+  uint64_t lo, hi;
+  for_each_ap([&](const object_config_ptr &cfg) {
+    if (field_band(cfg, lo, hi))
+      m_bands->insert(cfg->get_map_id(), lo, hi);
+  });
+  return true;
+}
+
+vector<shim::intern_stat_t> shim::get_intern_stats() {
+  map<string, unordered_set<const string *>> distinct;
+  map<string, size_t> n_values;
+  for_each_ap([&](const object_config_ptr &cfg) {
+    for (const auto &m : cfg->get_meta_info()) {
+      if (m.second.m_vtype != enum_type_istring)
+        continue;
+      if (cfg->is_lazy())
+        cfg->materialize(m.first.c_str());
+      distinct[m.first].insert(static_cast<istring *>(cfg->get_member(m.second).m_var)->get());
+      ++n_values[m.first];
+    }
+  });
+  vector<intern_stat_t> r;
+  for (const auto &d : distinct)
+    r.push_back(intern_stat_t{ d.first, n_values[d.first], d.second.size() });
+  return r;
+}
+
+bool shim::create_column_store(const vector<string> &fields
+                               /* = vector<string>() */) {
+  if (m_columns)
+    return false;
+  // meta info of ap_config is complete once an ap is created
+  bool deferred = object_config::is_id_deferred();
+  object_config::is_id_deferred() = true;
+  ap_config::create();
+  object_config::is_id_deferred() = deferred;
+
+  unique_ptr<column_store> cs(new column_store());
+  for (const auto &m : ap_config::get_meta()) {
+    if (!fields.empty() && find(fields.begin(), fields.end(), m.first) == fields.end())
+      continue;
+    switch (m.second.m_vtype) {
+      case enum_type_bool: cs->add_column<bool>(m.first, m.second.m_vtype); break;
+      case enum_type_int: cs->add_column<int>(m.first, m.second.m_vtype); break;
+      case enum_type_long: cs->add_column<long>(m.first, m.second.m_vtype); break;
+      case enum_type_unsigned: cs->add_column<unsigned>(m.first, m.second.m_vtype); break;
+      case enum_type_double: cs->add_column<double>(m.first, m.second.m_vtype); break;
+      default: break;
+    }
+  }
+  for (const auto &f : fields)
+    if (!cs->has_column(f))
+      return false;
+
+  m_columns = std::move(cs);
+  for_each_ap([this](const object_config_ptr &cfg) { column_config(cfg); });
+  return true;
+}
+
+// objects of ids in order of map id
+vector<object_config_ptr> shim::objects_of(vector<uint64_t> &ids) {
+  sort(ids.begin(), ids.end());
+  vector<object_config_ptr> objs;
+  objs.reserve(ids.size());
+  for (uint64_t id : ids) {
+    int slot = m_store.find(id);
+    if (slot >= 0)
+      objs.push_back(m_store.at(slot).m_val);
+  }
+  return objs;
+}
+
+vector<object_config_ptr> shim::find_in_radius(double lat, double lon,
+                                               double meters) {
+  vector<uint64_t> ids;
+  if (m_grid)
+    m_grid->for_each_in_radius(lat, lon, meters,
+                               [&ids](uint64_t id, double, double) { ids.push_back(id); });
+  else {
+    double plat, plon;
+    for_each_ap([&](const object_config_ptr &cfg) {
+      if (field_point(cfg, plat, plon)
+          && grid_index::distance_m(lat, lon, plat, plon) <= meters)
+        ids.push_back(cfg->get_map_id());
+    });
+  }
+  return objects_of(ids);
+}
+
+vector<object_config_ptr> shim::find_in_band(uint64_t lo, uint64_t hi) {
+  vector<uint64_t> ids;
+  if (m_bands)
+    m_bands->for_each_overlap(lo, hi,
+                              [&ids](uint64_t id, uint64_t, uint64_t) { ids.push_back(id); });
+  else {
+    uint64_t blo, bhi;
+    for_each_ap([&](const object_config_ptr &cfg) {
+      if (field_band(cfg, blo, bhi) && blo < bhi && blo < hi && bhi > lo)
+        ids.push_back(cfg->get_map_id());
+    });
+  }
+  return objects_of(ids);
+}
+
+vector<shim::overlap_t> shim::find_overlaps(const string &building) {
+  struct band_t {
+    uint64_t m_lo;
+    uint64_t m_hi;
+    uint64_t m_blacklist;
+    const object_config_ptr *m_ap;
+  };
+  vector<band_t> bands;
+  for (const auto &ap : find_children(building)) {
+    band_t b = { 0, 0, 0, &ap };
+    if (field_band(ap, b.m_lo, b.m_hi) && b.m_lo < b.m_hi) {
+      b.m_blacklist = blacklist_mask(ap);
+      bands.push_back(b);
+    }
+  }
+  sort(bands.begin(), bands.end(), [](const band_t &a, const band_t &b) {
+    return a.m_lo < b.m_lo;
+  });
+
+  // bands still open at the lower edge of the current one overlap it, those
+  // closed are dropped once, so the sweep visits each band and pair once
+  const uint64_t cbrs_lo = enum_cbrs_base_khz;
+  const uint64_t cbrs_hi = cbrs_lo + (uint64_t)enum_cbrs_n_channels * enum_cbrs_channel_khz;
+  vector<overlap_t> overlaps;
+  vector<const band_t *> open;
+  for (const auto &b : bands) {
+    size_t n = 0;
+    for (const band_t *o : open) {
+      if (o->m_hi <= b.m_lo)
+        continue;
+      open[n++] = o;
+      overlap_t ov = { *o->m_ap, *b.m_ap, b.m_lo, min(o->m_hi, b.m_hi), 0 };
+      uint64_t clo = max(ov.m_lo_khz, cbrs_lo), chi = min(ov.m_hi_khz, cbrs_hi);
+      if (clo < chi) {
+        uint64_t first = (clo - cbrs_lo) / enum_cbrs_channel_khz;
+        uint64_t last = (chi - 1 - cbrs_lo) / enum_cbrs_channel_khz;
+        uint64_t span = ((2ull << last) - 1) & ~((1ull << first) - 1);
+        ov.m_channels = span & ~(o->m_blacklist | b.m_blacklist);
+      }
+      // part of the overlap outside cbrs has no channel to blacklist
+      if (ov.m_channels || ov.m_lo_khz < cbrs_lo || ov.m_hi_khz > cbrs_hi)
+        overlaps.push_back(ov);
+    }
+    open.resize(n);
+    open.push_back(&b);
+  }
+  return overlaps;
+}
+
+vector<object_config_ptr> shim::find_in_box(double lat0, double lat1,
+                                            double lon0, double lon1) {
+  vector<uint64_t> ids;
+  if (m_grid)
+    m_grid->for_each_in_box(lat0, lat1, lon0, lon1,
+                            [&ids](uint64_t id, double, double) { ids.push_back(id); });
+  else {
+    double lat, lon;
+    for_each_ap([&](const object_config_ptr &cfg) {
+      if (!field_point(cfg, lat, lon) || lat < lat0 || lat > lat1)
+        return;
+      if (lon0 <= lon1 ? (lon >= lon0 && lon <= lon1) : (lon >= lon0 || lon <= lon1))
+        ids.push_back(cfg->get_map_id());
+    });
+  }
+  return objects_of(ids);
 }
 
+vector<object_config_ptr> shim::query(const query_t &terms) {
+  vector<object_config_ptr> result;
+
+  // the smallest id set of indexed terms, none matches if any is empty
+  const value_index::id_set *ids = nullptr;
+  vector<const value_index *> index(terms.size(), nullptr);
+  for (size_t i = 0; i < terms.size(); ++i) {
+    auto ix = m_indexes.find(terms[i].first);
+    if (ix == m_indexes.end())
+      continue;
+    index[i] = &ix->second;
+    const value_index::id_set *s = ix->second.find(terms[i].second);
+    if (!s)
+      return result;
+    if (!ids || s->size() < ids->size())
+      ids = s;
+  }
+
+  string text;
+  auto match = [&](const object_config_ptr &cfg) {
+    for (size_t i = 0; i < terms.size(); ++i) {
+      if (index[i]) {
+        const string *v = index[i]->value_of(cfg->get_map_id());
+        if (!v || *v != terms[i].second)
+          return false;
+      }
+      else if (!field_text(cfg, terms[i].first, text) || text != terms[i].second)
+        return false;
+    }
+    return true;
+  };
+
+  if (ids) {
+    result.reserve(ids->size());
+    for (uint64_t id : *ids) {
+      int slot = m_store.find(id);
+      if (slot >= 0 && match(m_store.at(slot).m_val))
+        result.push_back(m_store.at(slot).m_val);
+    }
+  }
+  else
+    for_each_ap([&](const object_config_ptr &cfg) {
+      if (match(cfg))
+        result.push_back(cfg);
+    });
+  sort(result.begin(), result.end(),
+       [](const object_config_ptr &a, const object_config_ptr &b) {
+         return a->get_map_id() < b->get_map_id();
+       });
+  return result;
+}
+
+// in key order, same as the ordered store it replaced
 list<object_config_ptr> shim::find_all_config() {
     list<object_config_ptr> objs;
-    for (auto p : m_store)
-        objs.push_back(p.second);
+    for (int slot : sorted_slots())
+        objs.push_back(m_store.at(slot).m_val);
     return objs;
 }
 
 void shim::dump(ostream &os /* = std::cout */) {
   ostringstream oss_all;
-  for (const auto &o : m_store) {
-    uint64_t map_id = o.second->get_map_id();
+  for (int slot : sorted_slots()) {
+    const object_config_ptr &o = m_store.at(slot).m_val;
+    uint64_t map_id = o->get_map_id();
     ostringstream oss_obj;
     if (object_config::is_site(map_id))
-      oss_obj << "site_config#" << o.second->get_obj_id();
+      oss_obj << "site_config#" << o->get_obj_id();
     else if (object_config::is_building(map_id))
-      oss_obj << "building_config#" << o.second->get_obj_id();
+      oss_obj << "building_config#" << o->get_obj_id();
     else if (object_config::is_ap(map_id))
-      oss_obj << "ap_config#" << o.second->get_obj_id();
+      oss_obj << "ap_config#" << o->get_obj_id();
     os << dec << noshowbase << setw(24) << setfill(' ') << oss_obj.str()
-       << ", 0x" << hex << setw(16) << setfill('0') << o.second->get_map_id()
-       << dec << ", " << o.second.get() << ", " << o.first << endl;
-    o.second->dump(oss_all);
+       << ", 0x" << hex << setw(16) << setfill('0') << o->get_map_id()
+       << dec << ", " << o.get() << ", " << m_store.at(slot).m_key << endl;
+    o->dump(oss_all);
     oss_all << endl;
   }
   os << "count: " << m_store.size() << endl;
-  for (const auto &k : m_id2key)
+  map<uint64_t, string> id_key = get_id_key();
+  for (const auto &k : id_key)
     os << "0x" << hex << noshowbase << setw(16) << setfill('0') << k.first
        << dec << " => " << k.second << endl;
-  os << "count: " << m_id2key.size() << endl << endl;
+  os << "count: " << id_key.size() << endl << endl;
   os << "detailes: " << endl << oss_all.str() << endl;
 }
 
@@ -476,6 +1112,46 @@ void shim::on_change(publisher *p, const char *var, enum change_type type,
                      void *pd /* = nullptr */) {
   cout << "received notification of " << change_types[type] << endl;
 
+  // field of object in the store changed, move it in the index of the field
+  auto ix = m_indexes.find(var);
+  bool moved = m_grid && (!strcmp(var, "latitude") || !strcmp(var, "longitude"));
+  bool retuned = m_bands && (!strcmp(var, "central_freq_khz")
+                             || !strcmp(var, "radio_bandwidth_mhz"));
+  column_base *col = m_columns ? m_columns->find_column(var) : nullptr;
+  object_config *cfg = dynamic_cast<object_config *>(p);
+  if (type == enum_change_update
+      && (ix != m_indexes.end() || moved || retuned || col) && cfg) {
+    uint64_t id = cfg->get_map_id();
+    int slot = m_store.find(id);
+    if (slot >= 0 && m_store.at(slot).m_val.get() == cfg && object_config::is_ap(id)) {
+      const object_config_ptr &oc = m_store.at(slot).m_val;
+      string text;
+      double lat, lon;
+      if (ix != m_indexes.end()) {
+        if (field_text(oc, var, text))
+          ix->second.insert(id, text);
+        else
+          ix->second.erase(id);
+      }
+      if (moved) {
+        if (field_point(oc, lat, lon))
+          m_grid->insert(id, lat, lon);
+        else
+          m_grid->erase(id);
+      }
+      uint64_t lo, hi;
+      if (retuned) {
+        if (field_band(oc, lo, hi))
+          m_bands->insert(id, lo, hi);
+        else
+          m_bands->erase(id);
+      }
+      int row = col ? m_columns->find(id) : -1;
+      if (row >= 0)
+        column_field(oc, row, var, *col);
+    }
+  }
+
   if (string(var) == "m_store") {
     uint64_t id = reinterpret_cast<uint64_t>(pd);
     if (type == enum_change_add) {
@@ -1,7 +1,7 @@
 #ifndef __SHIM_H__
 #define __SHIM_H__
 
-#include <any>
+#include <atomic>
 #include <iostream>
 #include <list>
 #include <map>
@@ -9,9 +9,18 @@
 #include <sstream>
 #include <tuple>
 #include <string>
+#include <unordered_map>
+#include <variant>
 #include <vector>
 
+#include "channel_set.h"
+#include "column.h"
 #include "const.h"
+#include "id_alloc.h"
+#include "index.h"
+#include "intern.h"
+#include "rcu.h"
+#include "small_vector.h"
 
 using namespace project;
 using namespace std;
@@ -33,10 +42,48 @@ enum var_trait_t {
   enum_var_undefined
 };
 
+// short list of strings, e.g. groups of an ap
+typedef small_vector<string, 2> string_vector;
+
+// NOTE: int32_t is an alias of int, both are decoded as enum_type_int
+template <typename T> struct var_type_of { static const var_type_t value = enum_type_undefined; };
+template <> struct var_type_of<string> { static const var_type_t value = enum_type_string; };
+template <> struct var_type_of<bool> { static const var_type_t value = enum_type_bool; };
+template <> struct var_type_of<int> { static const var_type_t value = enum_type_int; };
+template <> struct var_type_of<long> { static const var_type_t value = enum_type_long; };
+template <> struct var_type_of<unsigned> { static const var_type_t value = enum_type_unsigned; };
+template <> struct var_type_of<double> { static const var_type_t value = enum_type_double; };
+template <> struct var_type_of<list<int>> { static const var_type_t value = enum_type_list_int; };
+template <> struct var_type_of<list<string>> { static const var_type_t value = enum_type_list_string; };
+template <> struct var_type_of<istring> { static const var_type_t value = enum_type_istring; };
+template <> struct var_type_of<channel_set> { static const var_type_t value = enum_type_channel_set; };
+template <> struct var_type_of<string_vector> { static const var_type_t value = enum_type_string_vector; };
+
+// value of member, one alternative per type of the schema, uint64_t is obj_id.
+// Interned strings are carried as string
+typedef variant<monostate, string, bool, int, long, unsigned, double, uint64_t,
+                list<int>, list<string>, channel_set, string_vector> var_value;
+// member borrowed in place, the same alternatives as pointers
+typedef variant<monostate, const string *, const bool *, const int *,
+                const long *, const unsigned *, const double *,
+                const uint64_t *, const list<int> *, const list<string> *,
+                const channel_set *, const string_vector *> var_cref;
+
+// value of T borrowed by r, null if r holds another type
+template <typename T> const T *var_get(const var_cref &r) {
+  const T *const *p = get_if<const T *>(&r);
+  return p ? *p : nullptr;
+}
+
 struct meta_t {
   string m_node;
   string m_type;
   enum var_trait_t m_trait;
+  enum var_type_t m_vtype;
+  // field of class, the member is at the same offset in all its objects
+  size_t m_offset;
+  accessor *m_xetter;
+  int m_field; // id of field, i.e. position in meta map
   string to_string() {
     ostringstream oss;
     oss << "type = " << m_type
@@ -48,21 +95,68 @@ struct meta_t {
   }
 };
 
+// member of one object, located by the field of its class
 struct member_t {
   void *m_var;
   accessor *m_xetter;
 };
 
 typedef map<string, meta_t> meta_map;
-typedef map<string, member_t> member_map;
 
+// set of field ids of a class, sized from its field count, the words of
+// classes of up to 64 fields are kept inline
+class field_set {
+public:
+  field_set() : m_count(0) {}
+
+  // fields 0 to n - 1
+  void fill(size_t n) {
+    m_words.clear();
+    for (size_t i = 0; i < n; i += 64)
+      m_words.push_back(n - i >= 64 ? ~0ULL : (1ULL << (n - i)) - 1);
+    m_count = n;
+  }
+  void clear() {
+    m_words.clear();
+    m_count = 0;
+  }
+  bool test(int f) const {
+    return (size_t)f / 64 < m_words.size() &&
+           (m_words[f / 64] & (1ULL << (f % 64)));
+  }
+  void reset(int f) {
+    if (test(f)) {
+      m_words[f / 64] &= ~(1ULL << (f % 64));
+      --m_count;
+    }
+  }
+  bool none() const { return m_count == 0; }
+
+private:
+  small_vector<uint64_t, 1> m_words;
+  size_t m_count;
+};
+
+// the field of a member is looked up once, by the first lazy object of the
+// declaring class. Members of object_config are no field of any class
 #define decl_mem_var(t, v)                                            \
   protected:                                                          \
     t m_##v;                                                          \
+    const meta_t *field_##v() {                                       \
+      static const meta_t *s_meta = find_meta(#v);                    \
+      return s_meta;                                                  \
+    }                                                                 \
   public:                                                             \
-    const t &get_##v() { return m_##v; };                             \
+    const t &get_##v() {                                              \
+      if (m_lazy)                                                     \
+        materialize(field_##v());                                     \
+      return m_##v;                                                   \
+    };                                                                \
     void set_##v(const t &__) {                                       \
+      check_writable(#v);                                             \
       m_##v = __;                                                     \
+      if (m_lazy)                                                     \
+        settle(field_##v());                                          \
       notify(#v, enum_change_update);                                 \
     }
 
@@ -87,46 +181,49 @@ typedef map<string, member_t> member_map;
         meta_t m = {                                                  \
           std::move(string(#n)),                                      \
           std::move(string(#t)),                                      \
-          enum_var_required };                                        \
+          enum_var_required,                                          \
+          var_type_of<t>::value,                                      \
+          field_offset(&m_##v),                                       \
+          &xetter<t>::instance(),                                     \
+          -1 };                                                       \
         get_meta()[#v] = m;                                           \
-      }                                                               \
-      member_t b = {                                                  \
-        &m_##v,                                                       \
-        new xetter<t>() };                                            \
-      get_members()[#v] = b; }
+      } }
 
 #define def_optional_ex(t, v, n) {                                    \
       if (!is_inited()) {                                             \
         meta_t m = {                                                  \
           std::move(string(#n)),                                      \
           std::move(string(#t)),                                      \
-          enum_var_optional };                                        \
+          enum_var_optional,                                          \
+          var_type_of<t>::value,                                      \
+          field_offset(&m_##v),                                       \
+          &xetter<t>::instance(),                                     \
+          -1 };                                                       \
         get_meta()[#v] = m;                                           \
-      }                                                               \
-      member_t b = {                                                  \
-        &m_##v,                                                       \
-        new xetter<t>() };                                            \
-      get_members()[#v] = b; }
+      } }
 
 #define def_composed_ex(t, v, n) {                                    \
       if (!is_inited()) {                                             \
         meta_t m = {                                                  \
           std::move(string(#n)),                                      \
           std::move(string(#t)),                                      \
-          enum_var_composed };                                        \
+          enum_var_composed,                                          \
+          var_type_of<t>::value,                                      \
+          field_offset(&m_##v),                                       \
+          &xetter<t>::instance(),                                     \
+          -1 };                                                       \
         get_meta()[#v] = m;                                           \
-      }                                                               \
-      member_t b = {                                                  \
-        &m_##v,                                                       \
-        new xetter<t>() };                                            \
-      get_members()[#v] = b; }
+      } }
 
 #define def_required(t, v)          def_required_ex(t, v, v)
 #define def_optional(t, v)          def_optional_ex(t, v, v)
 #define def_composed(t, v)          def_composed_ex(t, v, v)
 
 #define end_def_vars()                                                \
-  is_inited() = true;                                                 \
+  if (!is_inited()) {                                                 \
+    number_fields(get_meta());                                        \
+    is_inited() = true;                                               \
+  }                                                                   \
     };
 
 // forward declaraction
@@ -224,20 +321,70 @@ private:
 class accessor {
   public:
     virtual ~accessor(){};
-    virtual void get(void *, std::any &) = 0;
-    virtual void set(void *, const std::any &) = 0;
+    virtual void get(void *, var_value &) = 0;
+    virtual void set(void *, const var_value &) = 0;
+    // value is moved into the member
+    virtual void set(void *, var_value &&) = 0;
+    // member in place, no copy
+    virtual var_cref ref(void *) = 0;
 };
 
+// stateless, one instance per type is shared by the members of all objects
 template <typename T>
 class xetter : public accessor {
   public:
-    virtual void get(void *param, std::any &value) {
+    static xetter &instance() {
+      static xetter s_instance;
+      return s_instance;
+    }
+    virtual void get(void *param, var_value &value) {
       value = *static_cast<T *>(param);
     }
-    virtual void set(void *param, const std::any &value) {
+    virtual void set(void *param, const var_value &value) {
       // *dereference
-      *static_cast<T *>(param) = std::any_cast<T>(value);
+      *static_cast<T *>(param) = std::get<T>(value);
+    }
+    virtual void set(void *param, var_value &&value) {
+      *static_cast<T *>(param) = std::get<T>(std::move(value));
+    }
+    virtual var_cref ref(void *param) {
+      return static_cast<const T *>(param);
+    }
+};
+
+// interned string member is read and written as string, e.g. by loaders
+template <>
+class xetter<istring> : public accessor {
+  public:
+    static xetter &instance() {
+      static xetter s_instance;
+      return s_instance;
+    }
+    virtual void get(void *param, var_value &value) {
+      value = static_cast<istring *>(param)->str();
     }
+    virtual void set(void *param, const var_value &value) {
+      *static_cast<istring *>(param) = std::get<string>(value);
+    }
+    virtual void set(void *param, var_value &&value) {
+      *static_cast<istring *>(param) = std::get<string>(value);
+    }
+    virtual var_cref ref(void *param) {
+      return &static_cast<istring *>(param)->str();
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// lazy_source
+// source record of object in lazy mode, decodes one member on demand
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class lazy_source {
+  public:
+    virtual ~lazy_source(){};
+    virtual void materialize(const meta_t &, const member_t &) = 0;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -254,44 +401,92 @@ public:
   virtual void dump(ostream & = std::cout);
   virtual void dump_meta(ostream & = std::cout);
 
-  static bool is_site(uint64_t map_id) { return (map_id >> enum_shift_site) != 0; }
-  static bool is_building(uint64_t map_id) { return ((map_id >> enum_shift_building) & 0xffff) != 0; }
-  static bool is_ap(uint64_t map_id) { return (map_id & 0xfffffffful) != 0; }
+  static bool is_site(uint64_t map_id) { return id_allocator::type_of(map_id) == enum_id_site; }
+  static bool is_building(uint64_t map_id) { return id_allocator::type_of(map_id) == enum_id_building; }
+  static bool is_ap(uint64_t map_id) { return id_allocator::type_of(map_id) == enum_id_ap; }
 
   static object_config_ptr create_site_config(int);
   static object_config_ptr create_building_config(int);
   static object_config_ptr create_ap_config(int);
   
   uint64_t get_map_id() { return m_map_id; }
-  member_map &get_members() { return m_members; }
+  // member of field in meta info of the class, not decoded in lazy mode, see
+  // materialize_all
+  member_t get_member(const meta_t &m) {
+    return member_t{ (char *)this + m.m_offset, m.m_xetter };
+  }
+
+  // lazy mode, members are decoded from the source on first access by
+  // get_<var>, get or materialize_all, a member assigned before is not decoded
+  // NOTE: not thread safe, first access writes the member
+  void set_lazy(const shared_ptr<lazy_source> &);
+  bool is_lazy() { return m_lazy != nullptr; }
+  void materialize(const char *var) { materialize(find_meta(var)); }
+  void materialize(const meta_t *);
+  void materialize_all();
+
+  // allocate map id from the allocator of the type, obj_id is its index. The
+  // id is released when the object is destroyed. Constructors skip it while
+  // ids are deferred on the calling thread, e.g. in workers of parallel
+  // parsing, so that ids can be assigned later in a deterministic order
+  virtual void assign_id() = 0;
+  static bool &is_id_deferred() {
+    static thread_local bool s_deferred = false;
+    return s_deferred;
+  }
 
-  bool set(const string &, const std::any &);
-  bool get(const string &, std::any &);
+  bool set(const string &, const var_value &);
+  bool set(const string &, var_value &&);
+  bool get(const string &, var_value &);
+  // member borrowed in place, valid until it is assigned or the object is
+  // destroyed
+  bool get_ref(const string &, var_cref &);
+
+  // in a snapshot published by shim in concurrent mode, read by reader threads
+  // in place, so its members must not be assigned any more, see
+  // shim::set_concurrent
+  bool is_published() { return m_published; }
 
   decl_mem_var(uint64_t, obj_id);
   decl_mem_var(int, ver);
 
 protected:
-  object_config() : m_map_id(0){};
+  friend class shim;
+
+  object_config() : m_map_id(0), m_published(false) { m_obj_id = 0; };
   object_config(const object_config &);
   object_config &operator=(const object_config &);
-  virtual ~object_config() {
-    // release members xetter object
-    for (auto b : m_members) {
-      delete b.second.m_xetter;
-    }
-  }
+  virtual ~object_config() { release_id(); }
 
-  enum bit_shift_t {
-    enum_shift_site = 48,
-    enum_shift_building = 32,
-    enum_shift_ap = 0
-  };
+  void allocate_id(id_type_t type) {
+    release_id();
+    m_map_id = id_allocator::of_type(type).allocate();
+    m_obj_id = id_allocator::index_of(m_map_id);
+  }
+  void release_id() {
+    if (m_map_id)
+      id_allocator::of_type(id_allocator::type_of(m_map_id)).release(m_map_id);
+    m_map_id = 0;
+  }
 
-  virtual void generate_map_id() = 0;
+  size_t field_offset(const void *var) {
+    return (const char *)var - (const char *)this;
+  }
+  static void number_fields(meta_map &);
+
+  // field of var in meta info of the class, null if none
+  const meta_t *find_meta(const char *);
+  void settle(const char *var) { settle(find_meta(var)); }
+  void settle(const meta_t *);
+  void check_writable(const char *var) {
+    if (m_published)
+      throw logic_error(string(var) + " of published object is read only");
+  }
 
   uint64_t m_map_id;
-  member_map m_members;
+  shared_ptr<lazy_source> m_lazy;
+  field_set m_pending; // fields not decoded yet from the lazy source
+  bool m_published;
 
 }; // class object_config
 
@@ -312,6 +507,7 @@ public:
   }
 
   virtual string get_key() { return m_name; }
+  virtual void assign_id();
 #if 0
   virtual void dump(ostream & = std::cout);
 #endif
@@ -352,12 +548,6 @@ protected:
   site_config(const site_config &);
   site_config &operator=(const site_config &);
 
-  virtual void generate_map_id() {
-    m_map_id = (uint64_t)(m_obj_id + 1) << enum_shift_site;
-  }
-
-  static int s_n_site;
-
 }; // class site_config
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -377,6 +567,7 @@ public:
   }
 
   virtual string get_key() { return m_name; }
+  virtual void assign_id();
 #if 0
   virtual void dump(ostream & = std::cout);
 #endif
@@ -405,12 +596,6 @@ protected:
   building_config(const building_config &);
   building_config &operator=(const building_config &);
 
-  virtual void generate_map_id() {
-    m_map_id = (uint64_t)(m_obj_id + 1) << enum_shift_building;
-  }
-
-  static int s_n_building;
-
 }; // class building_config
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -430,13 +615,14 @@ public:
   }
 
   virtual string get_key() { return m_fcc_id + ":" + m_serial_number; }
+  virtual void assign_id();
 #if 0
   virtual void dump(ostream & = std::cout);
 #endif
 
   decl_mem_var(string, name);
-  decl_mem_var(string, site_name);
-  decl_mem_var(string, building_name);
+  decl_mem_var(istring, site_name);
+  decl_mem_var(istring, building_name);
 
   decl_mem_var(bool, admin_state);
   decl_mem_var(bool, single_step);
@@ -447,24 +633,24 @@ public:
   decl_mem_var(int, trans_expire_margin);
   decl_mem_var(unsigned, central_freq_khz);
   decl_mem_var(unsigned, radio_bandwidth_mhz);
-  decl_mem_var(list<int>, channel_blacklist);
+  decl_mem_var(channel_set, channel_blacklist);
 
   decl_mem_var(string, fcc_id);
   decl_mem_var(string, serial_number);
-  decl_mem_var(string, category);
+  decl_mem_var(istring, category);
   decl_mem_var(string, call_sign);
-  decl_mem_var(list<string>, meas_capabilities);
-  decl_mem_var(string, radio_technology);
-  decl_mem_var(string, vendor);
-  decl_mem_var(string, model);
-  decl_mem_var(string, software_version);
-  decl_mem_var(string, hardware_version);
-  decl_mem_var(string, firmware_version);
+  decl_mem_var(string_vector, meas_capabilities);
+  decl_mem_var(istring, radio_technology);
+  decl_mem_var(istring, vendor);
+  decl_mem_var(istring, model);
+  decl_mem_var(istring, software_version);
+  decl_mem_var(istring, hardware_version);
+  decl_mem_var(istring, firmware_version);
   decl_mem_var(int, eirp_capability);
   decl_mem_var(double, latitude);
   decl_mem_var(double, longitude);
   decl_mem_var(double, height);
-  decl_mem_var(string, height_type);
+  decl_mem_var(istring, height_type);
   decl_mem_var(double, horizontal_accuracy);
   decl_mem_var(double, vertical_accuracy);
   decl_mem_var(bool, indoor_site);
@@ -472,9 +658,9 @@ public:
   decl_mem_var(int, antenna_downtilt);
   decl_mem_var(int, antenna_gain);
   decl_mem_var(int, antenna_beamwidth);
-  decl_mem_var(string, antenna_model);
-  decl_mem_var(list<string>, group_types);
-  decl_mem_var(list<string>, group_ids);
+  decl_mem_var(istring, antenna_model);
+  decl_mem_var(string_vector, group_types);
+  decl_mem_var(string_vector, group_ids);
   decl_mem_var(string, protected_header);
   decl_mem_var(string, encoded_cpi_signed_data);
   decl_mem_var(string, digital_signature);
@@ -486,8 +672,8 @@ public:
   begin_def_vars()
     // NOTE: do not define composed field
     def_required(string, name)
-    def_required(string, site_name)
-    def_required(string, building_name)
+    def_required(istring, site_name)
+    def_required(istring, building_name)
 
     def_required(bool, admin_state)
     def_required(bool, single_step)
@@ -498,24 +684,24 @@ public:
     def_optional(int, trans_expire_margin)
     def_required(unsigned, central_freq_khz)
     def_required(unsigned, radio_bandwidth_mhz)
-    def_required(list<int>, channel_blacklist)
+    def_required(channel_set, channel_blacklist)
 
     def_required(string, fcc_id)
     def_required(string, serial_number)
-    def_required(string, category)
+    def_required(istring, category)
     def_required(string, call_sign)
-    def_required(list<string>, meas_capabilities)
-    def_required(string, radio_technology)
-    def_required(string, vendor)
-    def_required(string, model)
-    def_required(string, software_version)
-    def_required(string, hardware_version)
-    def_required(string, firmware_version)
+    def_required(string_vector, meas_capabilities)
+    def_required(istring, radio_technology)
+    def_required(istring, vendor)
+    def_required(istring, model)
+    def_required(istring, software_version)
+    def_required(istring, hardware_version)
+    def_required(istring, firmware_version)
     def_required(int, eirp_capability)
     def_required(double, latitude)
     def_required(double, longitude)
     def_required(double, height)
-    def_required(string, height_type)
+    def_required(istring, height_type)
     def_required(double, horizontal_accuracy)
     def_required(double, vertical_accuracy)
     def_required(bool, indoor_site)
@@ -523,9 +709,9 @@ public:
     def_required(int, antenna_downtilt)
     def_required(int, antenna_gain)
     def_required(int, antenna_beamwidth)
-    def_required(string, antenna_model)
-    def_required_ex(list<string>, group_types, groups.[%d].type)
-    def_required_ex(list<string>, group_ids, groups.[%d].id)
+    def_required(istring, antenna_model)
+    def_required_ex(string_vector, group_types, groups.[%d].type)
+    def_required_ex(string_vector, group_ids, groups.[%d].id)
     def_optional_ex(string, protected_header, cpi_signature_data.protected_header)
     def_optional_ex(string, encoded_cpi_signed_data, cpi_signature_data.encoded_cpi_signed_data)
     def_optional_ex(string, digital_signature, cpi_signature_data.digital_signature)
@@ -540,12 +726,6 @@ protected:
   ap_config(const ap_config &);
   ap_config &operator=(const ap_config &);
 
-  virtual void generate_map_id() {
-    m_map_id = (uint64_t)(m_obj_id + 1) << enum_shift_ap;
-  }
-
-  static int s_n_ap;
-
 }; // class ap_config
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -564,10 +744,11 @@ public:
   }
   
   virtual string get_key() { return m_fcc_id + ":" + m_serial_number; }
+  virtual void assign_id();
 
   decl_mem_var(string, name);
-  decl_mem_var(string, site_name);
-  decl_mem_var(string, building_name);
+  decl_mem_var(istring, site_name);
+  decl_mem_var(istring, building_name);
 
   decl_mem_var(bool, admin_state);
   decl_mem_var(bool, single_step);
@@ -578,24 +759,24 @@ public:
   decl_mem_var(int, trans_expire_margin);
   decl_mem_var(unsigned, central_freq_khz);
   decl_mem_var(unsigned, radio_bandwidth_mhz);
-  decl_mem_var(list<int>, channel_blacklist);
+  decl_mem_var(channel_set, channel_blacklist);
 
   decl_mem_var(string, fcc_id);
   decl_mem_var(string, serial_number);
-  decl_mem_var(string, category);
+  decl_mem_var(istring, category);
   decl_mem_var(string, call_sign);
-  decl_mem_var(list<string>, meas_capabilities);
-  decl_mem_var(string, radio_technology);
-  decl_mem_var(string, vendor);
-  decl_mem_var(string, model);
-  decl_mem_var(string, software_version);
-  decl_mem_var(string, hardware_version);
-  decl_mem_var(string, firmware_version);
+  decl_mem_var(string_vector, meas_capabilities);
+  decl_mem_var(istring, radio_technology);
+  decl_mem_var(istring, vendor);
+  decl_mem_var(istring, model);
+  decl_mem_var(istring, software_version);
+  decl_mem_var(istring, hardware_version);
+  decl_mem_var(istring, firmware_version);
   decl_mem_var(int, eirp_capability);
   decl_mem_var(double, latitude);
   decl_mem_var(double, longitude);
   decl_mem_var(double, height);
-  decl_mem_var(string, height_type);
+  decl_mem_var(istring, height_type);
   decl_mem_var(double, horizontal_accuracy);
   decl_mem_var(double, vertical_accuracy);
   decl_mem_var(bool, indoor_site);
@@ -603,9 +784,9 @@ public:
   decl_mem_var(int, antenna_downtilt);
   decl_mem_var(int, antenna_gain);
   decl_mem_var(int, antenna_beamwidth);
-  decl_mem_var(string, antenna_model);
-  decl_mem_var(list<string>, group_types);
-  decl_mem_var(list<string>, group_ids);
+  decl_mem_var(istring, antenna_model);
+  decl_mem_var(string_vector, group_types);
+  decl_mem_var(string_vector, group_ids);
   decl_mem_var(string, protected_header);
   decl_mem_var(string, encoded_cpi_signed_data);
   decl_mem_var(string, digital_signature);
@@ -618,8 +799,8 @@ public:
 
   begin_def_vars()
     def_composed(string, name)
-    def_composed(string, site_name)
-    def_composed(string, building_name)
+    def_composed(istring, site_name)
+    def_composed(istring, building_name)
 
     def_required(bool, admin_state)
     def_required(bool, single_step)
@@ -630,24 +811,24 @@ public:
     def_optional(int, trans_expire_margin)
     def_required(unsigned, central_freq_khz)
     def_required(unsigned, radio_bandwidth_mhz)
-    def_required(list<int>, channel_blacklist)
+    def_required(channel_set, channel_blacklist)
 
     def_required(string, fcc_id)
     def_required(string, serial_number)
-    def_required(string, category)
+    def_required(istring, category)
     def_required(string, call_sign)
-    def_required(list<string>, meas_capabilities)
-    def_required(string, radio_technology)
-    def_required(string, vendor)
-    def_required(string, model)
-    def_required(string, software_version)
-    def_required(string, hardware_version)
-    def_required(string, firmware_version)
+    def_required(string_vector, meas_capabilities)
+    def_required(istring, radio_technology)
+    def_required(istring, vendor)
+    def_required(istring, model)
+    def_required(istring, software_version)
+    def_required(istring, hardware_version)
+    def_required(istring, firmware_version)
     def_required(int, eirp_capability)
     def_required(double, latitude)
     def_required(double, longitude)
     def_required(double, height)
-    def_required(string, height_type)
+    def_required(istring, height_type)
     def_required(double, horizontal_accuracy)
     def_required(double, vertical_accuracy)
     def_required(bool, indoor_site)
@@ -655,9 +836,9 @@ public:
     def_required(int, antenna_downtilt)
     def_required(int, antenna_gain)
     def_required(int, antenna_beamwidth)
-    def_required(string, antenna_model)
-    def_required_ex(list<string>, group_types, groups.[%d].type)
-    def_required_ex(list<string>, group_ids, groups.[%d].id)
+    def_required(istring, antenna_model)
+    def_required_ex(string_vector, group_types, groups.[%d].type)
+    def_required_ex(string_vector, group_ids, groups.[%d].id)
     // modified node path, removed outer group
     def_optional(string, protected_header)
     def_optional(string, encoded_cpi_signed_data)
@@ -678,9 +859,6 @@ protected:
   ap_config_v2(const ap_config_v2 &);
   ap_config_v2 &operator=(const ap_config_v2 &);
 
-  virtual void generate_map_id() { m_map_id = (uint64_t)(m_obj_id + 1) << enum_shift_ap; }
-
-  static int s_n_ap;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -700,6 +878,7 @@ public:
   }
 
   virtual string get_key() { return "app_config"; }
+  virtual void assign_id();
 #if 0
   virtual void dump(ostream & = std::cout);
 #endif
@@ -727,10 +906,6 @@ protected:
   app_config(const app_config &);
   app_config &operator=(const app_config &);
 
-  virtual void generate_map_id() {
-    m_map_id = (uint64_t)m_obj_id << enum_shift_site;
-  }
-
 }; // class app_config
 
 // backwards compatible
@@ -745,6 +920,30 @@ using ap_config_v1 = ap_config;
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+// immutable version of the store published for concurrent readers, see
+// shim::publish, objects must not be changed once published
+class shim_snapshot {
+public:
+  // null if not found, the reference is valid while the reader is held
+  const object_config_ptr &find_config(const string &) const;
+  const object_config_ptr &find_config(uint64_t) const;
+  store_index<object_config_ptr>::ordered_range ordered_view() const {
+    return m_store.ordered();
+  }
+  template <typename F> void for_each_config(F f) const {
+    m_store.for_each([&f](const store_index<object_config_ptr>::entry &e) { f(e.m_val); });
+  }
+  size_t size() const { return m_store.size(); }
+  uint64_t get_version() const { return m_version; }
+
+private:
+  friend class shim;
+
+  store_index<object_config_ptr> m_store;
+  uint64_t m_version = 0;
+
+}; // class shim_snapshot
+
 class shim : public publisher, public subscriber {
 public:
   // access singleton instance of shim class, thread safe
@@ -766,11 +965,151 @@ public:
 
   void dump(ostream & = std::cout);
 
-  // access key and id stores in shim
-  map<uint64_t, string> get_id_key() { return m_id2key; }
-  map<string, object_config_ptr> get_key_obj() { return m_store; }
-  vector<object_config_ptr> get_ordered_oc() { return ordered_oc; }
-  void clear_ordered_oc() { ordered_oc.clear(); }
+  // binary snapshot of all objects in insertion order, keyed by the hash of
+  // the source cfg files, load fails without touching the store if the file
+  // is missing, stale or corrupt
+  bool save_snapshot(const string &, uint64_t, int);
+  bool load_snapshot(const string &, uint64_t, int &);
+
+  // access key and id stores in shim, ordered copies of the index
+  map<uint64_t, string> get_id_key();
+  map<string, object_config_ptr> get_key_obj();
+  vector<object_config_ptr> get_ordered_oc() const;
+
+  // views and visitors of the store in place, the pointers are not copied,
+  // the store must not be changed while they are used. Objects are in
+  // insertion order, a replaced object takes the position of the old one
+  store_index<object_config_ptr>::ordered_range ordered_view() const {
+    return m_store.ordered();
+  }
+  size_t size() const { return m_store.size(); }
+
+  // concurrent mode, the store is written by one thread at a time and
+  // published by publish() to any number of reader threads. A reader pins
+  // the snapshot current at construction and never blocks. Its objects are
+  // shared with the store and read only, see set_concurrent, e.g.
+  //   shim::reader r;
+  //   const object_config_ptr &oc = r->find_config(key);
+  class reader {
+  public:
+    reader() : m_shim(shim::instance()) {
+      // read_lock fences its epoch store before this load
+      m_shim.m_rcu.read_lock();
+      m_snap = m_shim.m_snap.load(memory_order_acquire);
+    }
+    ~reader() { m_shim.m_rcu.read_unlock(); }
+    const shim_snapshot &operator*() const { return *m_snap; }
+    const shim_snapshot *operator->() const { return m_snap; }
+
+  private:
+    reader(const reader &) = delete;
+    reader &operator=(const reader &) = delete;
+
+    shim &m_shim;
+    const shim_snapshot *m_snap;
+  };
+
+  // objects are shared by the store and snapshots, not copied. Once published
+  // an object is read only, setters throw logic_error, a writer replaces it
+  // by a new object with insert_config instead, as reload_config does.
+  // Objects are writable again when concurrent mode is turned off
+  void set_concurrent(bool);
+  bool is_concurrent() const { return m_concurrent; }
+  // copy the store into a new snapshot and swap it in for new readers, the
+  // previous one is deleted once its readers are gone. Lazy objects are
+  // decoded first and all objects are marked published since readers must
+  // not write. No-op unless concurrent
+  void publish();
+  size_t get_n_retired() { return m_rcu.get_n_retired(); }
+
+  // hierarchy of sites, buildings and aps by site_name and building_name,
+  // kept by insert_config and delete_config. Children are in insertion order
+  // and keep their position when replaced, a child may refer to a parent
+  // which is not inserted yet
+  object_config_ptr find_parent(const string &) const;
+  span_view<object_config_ptr> find_children(const string &) const;
+
+  // secondary indexes of aps by the value of a field, e.g. vendor, kept by
+  // insert_config, delete_config and updates of the field. Scalar fields are
+  // indexed by their text, fields of other types are not indexed
+  bool create_index(const string &);
+  void drop_index(const string &);
+  bool has_index(const string &field) const { return m_indexes.count(field) != 0; }
+
+  // aps matching all (field, value) terms, in order of map id. The indexed
+  // term with the fewest ids drives the query and the other terms are
+  // checked on its objects, all aps are scanned only if no term is indexed
+  typedef vector<pair<string, string>> query_t;
+  vector<object_config_ptr> query(const query_t &);
+
+  // spatial index of aps by latitude and longitude in cells of cell_deg
+  // degrees, kept as the secondary indexes
+  bool create_spatial_index(double cell_deg = 0.01);
+  void drop_spatial_index() { m_grid.reset(); }
+  bool has_spatial_index() const { return m_grid != nullptr; }
+
+  // aps within meters of a point or in a box of degrees, in order of map id.
+  // A box with lon0 > lon1 crosses the antimeridian, all aps are scanned if
+  // there is no spatial index
+  vector<object_config_ptr> find_in_radius(double, double, double);
+  vector<object_config_ptr> find_in_box(double, double, double, double);
+
+  // band index of aps by [central_freq_khz - bandwidth / 2,
+  // central_freq_khz + bandwidth / 2) in kHz, kept as the secondary indexes
+  bool create_band_index();
+  void drop_band_index() { m_bands.reset(); }
+  bool has_band_index() const { return m_bands != nullptr; }
+
+  // aps whose band overlaps [lo_khz, hi_khz), in order of map id, all aps
+  // are scanned if there is no band index
+  vector<object_config_ptr> find_in_band(uint64_t, uint64_t);
+
+  // pair of aps of a building with overlapping bands. Channels is the mask of
+  // cbrs channels in the overlap which neither ap has blacklisted, a pair is
+  // reported only if some part of the overlap is not blacklisted by either
+  struct overlap_t {
+    object_config_ptr m_a;
+    object_config_ptr m_b;
+    uint64_t m_lo_khz;
+    uint64_t m_hi_khz;
+    uint64_t m_channels;
+  };
+  // all pairs of aps of building by a sweep over their bands sorted by lower
+  // edge, pairs in order of the later lower edge
+  vector<overlap_t> find_overlaps(const string &);
+
+  // interned fields of aps by name, the values and the distinct ones among
+  // them, i.e. the strings stored, the ratio is the dedup ratio of the field
+  struct intern_stat_t {
+    string m_field;
+    size_t m_n_values;
+    size_t m_n_distinct;
+  };
+  vector<intern_stat_t> get_intern_stats();
+
+  // columnar copy of scalar fields of aps, i.e. bool, int, unsigned, long
+  // and double, one column per field indexed by the index of map id, kept as
+  // the secondary indexes. All scalar fields of ap_config if none are given,
+  // false if a given field is not one of them
+  bool create_column_store(const vector<string> & = vector<string>());
+  void drop_column_store() { m_columns.reset(); }
+  bool has_column_store() const { return m_columns != nullptr; }
+  // null if there is none, valid until it is dropped
+  const column_store *get_column_store() const { return m_columns.get(); }
+
+  // f(const object_config_ptr &) for each live object, unordered
+  template <typename F> void for_each_config(F f) const {
+    m_store.for_each([&f](const store_index<object_config_ptr>::entry &e) { f(e.m_val); });
+  }
+  template <typename F> void for_each_site(F f) const {
+    for_each_level(f, object_config::is_site);
+  }
+  template <typename F> void for_each_building(F f) const {
+    for_each_level(f, object_config::is_building);
+  }
+  template <typename F> void for_each_ap(F f) const {
+    for_each_level(f, object_config::is_ap);
+  }
 
 protected:
   virtual void on_change(publisher *, const char *, enum change_type,
@@ -782,9 +1121,56 @@ private:
   shim(const shim &);
   shim &operator=(const shim &);
 
-  map<uint64_t, string> m_id2key;
-  map<string, object_config_ptr> m_store;
-  vector<object_config_ptr> ordered_oc;
+  // published version for readers
+  bool m_concurrent = false;
+  atomic<const shim_snapshot *> m_snap;
+  rcu_domain m_rcu;
+
+  // objects by key and by map id, in insertion order
+  store_index<object_config_ptr> m_store;
+
+  // node of hierarchy, kept while the object or any child is in the store
+  struct node_t {
+    object_config_ptr m_obj;
+    string m_parent;
+    vector<object_config_ptr> m_children;
+    size_t m_pos; // position in children of parent, may be greater after erase
+  };
+  unordered_map<string, node_t> m_nodes;
+
+  static string parent_key(const object_config_ptr &);
+  void link(const string &, const object_config_ptr &, const object_config_ptr &);
+  void unlink(const string &, const object_config_ptr &);
+  static size_t child_pos(const vector<object_config_ptr> &, size_t,
+                          const object_config_ptr &);
+
+  // secondary indexes by field
+  map<string, value_index> m_indexes;
+
+  unique_ptr<grid_index> m_grid;
+  unique_ptr<interval_index> m_bands;
+  unique_ptr<column_store> m_columns;
+
+  static bool field_text(const object_config_ptr &, const string &, string &);
+  static bool field_point(const object_config_ptr &, double &, double &);
+  static bool field_band(const object_config_ptr &, uint64_t &, uint64_t &);
+  static uint64_t blacklist_mask(const object_config_ptr &);
+  vector<object_config_ptr> objects_of(vector<uint64_t> &);
+  static void column_field(const object_config_ptr &, uint32_t, const string &,
+                           column_base &);
+  void column_config(const object_config_ptr &);
+  void index_config(const object_config_ptr &);
+  void unindex_config(uint64_t);
+
+  // slots of live objects in key order, for dump and key ordered copies
+  vector<int> sorted_slots() const;
+
+  template <typename F> void for_each_level(F &f, bool (*is_level)(uint64_t)) const {
+    m_store.for_each([&f, is_level](const store_index<object_config_ptr>::entry &e) {
+      if (is_level(e.m_id))
+        f(e.m_val);
+    });
+  }
 
 }; // class shim
 
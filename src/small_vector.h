@@ -0,0 +1,167 @@
+#ifndef __SMALL_VECTOR_H__
+#define __SMALL_VECTOR_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// small_vector
+// contiguous sequence with room for N elements inside the object, the
+// elements move to the heap only when there are more than N. Meant for short
+// lists of members, e.g. groups of an ap, which mostly have one or two
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T, size_t N> class small_vector {
+  static_assert(N > 0, "small_vector needs inline room");
+
+public:
+  typedef T value_type;
+  typedef T *iterator;
+  typedef const T *const_iterator;
+
+  small_vector() : m_data(inline_data()), m_size(0), m_capacity(N) {}
+  small_vector(initializer_list<T> l) : small_vector() {
+    reserve(l.size());
+    for (const auto &v : l)
+      push_back(v);
+  }
+  template <typename I> small_vector(I first, I last) : small_vector() {
+    for (; first != last; ++first)
+      push_back(*first);
+  }
+  small_vector(const small_vector &rhs) : small_vector() {
+    reserve(rhs.m_size);
+    for (const auto &v : rhs)
+      push_back(v);
+  }
+  small_vector(small_vector &&rhs) : small_vector() { take(rhs); }
+  ~small_vector() {
+    clear();
+    if (!is_inline())
+      ::operator delete(m_data);
+  }
+
+  small_vector &operator=(const small_vector &rhs) {
+    if (this != &rhs) {
+      clear();
+      reserve(rhs.m_size);
+      for (const auto &v : rhs)
+        push_back(v);
+    }
+    return *this;
+  }
+  small_vector &operator=(small_vector &&rhs) {
+    if (this != &rhs) {
+      clear();
+      take(rhs);
+    }
+    return *this;
+  }
+
+  void push_back(const T &v) { emplace_back(v); }
+  void push_back(T &&v) { emplace_back(std::move(v)); }
+  template <typename... A> T &emplace_back(A &&...args) {
+    if (m_size == m_capacity) {
+      // v may be an element, construct it before the elements move
+      T v(std::forward<A>(args)...);
+      reserve(m_capacity * 2);
+      return *new (m_data + m_size++) T(std::move(v));
+    }
+    return *new (m_data + m_size++) T(std::forward<A>(args)...);
+  }
+  void pop_back() { m_data[--m_size].~T(); }
+
+  void clear() {
+    for (size_t i = 0; i < m_size; ++i)
+      m_data[i].~T();
+    m_size = 0;
+  }
+  void reserve(size_t n) {
+    if (n <= m_capacity)
+      return;
+    T *p = static_cast<T *>(::operator new(n * sizeof(T)));
+    for (size_t i = 0; i < m_size; ++i) {
+      new (p + i) T(std::move(m_data[i]));
+      m_data[i].~T();
+    }
+    if (!is_inline())
+      ::operator delete(m_data);
+    m_data = p;
+    m_capacity = n;
+  }
+
+  T &operator[](size_t i) { return m_data[i]; }
+  const T &operator[](size_t i) const { return m_data[i]; }
+  const T &at(size_t i) const {
+    if (i >= m_size)
+      throw out_of_range("small_vector index");
+    return m_data[i];
+  }
+  T &front() { return m_data[0]; }
+  const T &front() const { return m_data[0]; }
+  T &back() { return m_data[m_size - 1]; }
+  const T &back() const { return m_data[m_size - 1]; }
+
+  T *data() { return m_data; }
+  const T *data() const { return m_data; }
+  iterator begin() { return m_data; }
+  iterator end() { return m_data + m_size; }
+  const_iterator begin() const { return m_data; }
+  const_iterator end() const { return m_data + m_size; }
+  const_iterator cbegin() const { return m_data; }
+  const_iterator cend() const { return m_data + m_size; }
+
+  size_t size() const { return m_size; }
+  size_t capacity() const { return m_capacity; }
+  bool empty() const { return m_size == 0; }
+  // elements are inside the object, no heap block is held
+  bool is_inline() const { return m_data == inline_data(); }
+
+  bool operator==(const small_vector &rhs) const {
+    return m_size == rhs.m_size && equal(begin(), end(), rhs.begin());
+  }
+  bool operator!=(const small_vector &rhs) const { return !(*this == rhs); }
+
+private:
+  T *inline_data() { return reinterpret_cast<T *>(m_inline); }
+  const T *inline_data() const { return reinterpret_cast<const T *>(m_inline); }
+
+  // steal the heap block of rhs or move its inline elements, rhs is empty
+  void take(small_vector &rhs) {
+    if (!rhs.is_inline()) {
+      if (!is_inline())
+        ::operator delete(m_data);
+      m_data = rhs.m_data;
+      m_size = rhs.m_size;
+      m_capacity = rhs.m_capacity;
+      rhs.m_data = rhs.inline_data();
+      rhs.m_size = 0;
+      rhs.m_capacity = N;
+      return;
+    }
+    reserve(rhs.m_size);
+    for (auto &v : rhs)
+      push_back(std::move(v));
+    rhs.clear();
+  }
+
+  T *m_data;
+  size_t m_size;
+  size_t m_capacity;
+  alignas(T) unsigned char m_inline[N * sizeof(T)];
+
+}; // class small_vector
+
+} // namespace project
+
+#endif // __SMALL_VECTOR_H__
@@ -0,0 +1,307 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "reader.h"
+#include "shim.h"
+#include "utils.h"
+
+using namespace project;
+using namespace std;
+
+namespace project {
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// shim snapshot
+// binary image of the shim store, values in host byte order
+//
+//   header: magic, format, source hash, schema hash, cfg ver
+//   object: class tag, ver, members in the order of the meta map
+//   trailer: hash of all preceding bytes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+static const char s_snap_magic[8] = { 'C', 'F', 'G', 'S', 'N', 'A', 'P', 0 };
+static const uint32_t s_snap_format = 2;
+
+enum snap_tag_t {
+  enum_snap_site,
+  enum_snap_building,
+  enum_snap_ap,
+  enum_snap_ap_v2,
+  enum_snap_app,
+  enum_snap_n_tags
+};
+
+static object_config_ptr snap_create(int tag) {
+  switch (tag) {
+    case enum_snap_site: return site_config::create();
+    case enum_snap_building: return building_config::create();
+    case enum_snap_ap: return ap_config::create();
+    case enum_snap_ap_v2: return ap_config_v2::create();
+    case enum_snap_app: return app_config::create();
+    default: return nullptr;
+  }
+}
+
+static int snap_tag(const object_config_ptr &oc) {
+  object_config *o = oc.get();
+  if (dynamic_cast<site_config *>(o))
+    return enum_snap_site;
+  if (dynamic_cast<building_config *>(o))
+    return enum_snap_building;
+  if (dynamic_cast<ap_config *>(o))
+    return enum_snap_ap;
+  if (dynamic_cast<ap_config_v2 *>(o))
+    return enum_snap_ap_v2;
+  if (dynamic_cast<app_config *>(o))
+    return enum_snap_app;
+  return -1;
+}
+
+// hash of member names and types of all classes, a snapshot written by a
+// build with different schema is stale
+static uint64_t snap_schema_hash() {
+  bool deferred = object_config::is_id_deferred();
+  object_config::is_id_deferred() = true;
+  uint64_t h = util_hash_fnv1a(nullptr, 0);
+  for (int tag = 0; tag < enum_snap_n_tags; ++tag) {
+    object_config_ptr oc = snap_create(tag);
+    for (const auto &v : oc->get_meta_info()) {
+      h = util_hash_fnv1a(v.first.data(), v.first.size() + 1, h);
+      h = util_hash_fnv1a(&v.second.m_vtype, sizeof(v.second.m_vtype), h);
+    }
+  }
+  object_config::is_id_deferred() = deferred;
+  return h;
+}
+
+class snap_writer {
+public:
+  template <typename T> void put(const T &v) {
+    m_buf.append(reinterpret_cast<const char *>(&v), sizeof(v));
+  }
+  void put(const string &v) {
+    put((uint32_t)v.size());
+    m_buf.append(v);
+  }
+  template <typename T> void put(const list<T> &v) {
+    put((uint32_t)v.size());
+    for (const auto &e : v)
+      put(e);
+  }
+  template <typename T, size_t N> void put(const small_vector<T, N> &v) {
+    put((uint32_t)v.size());
+    for (const auto &e : v)
+      put(e);
+  }
+  void put_member(var_type_t type, void *var);
+
+  string &buffer() { return m_buf; }
+
+private:
+  string m_buf;
+};
+
+class snap_reader {
+public:
+  snap_reader(const char *data, size_t len) : m_data(data), m_len(len), m_pos(0) {}
+
+  template <typename T> bool get(T &v) {
+    if (m_len - m_pos < sizeof(v))
+      return false;
+    memcpy(&v, m_data + m_pos, sizeof(v));
+    m_pos += sizeof(v);
+    return true;
+  }
+  bool get(string &v) {
+    uint32_t n = 0;
+    if (!get(n) || m_len - m_pos < n)
+      return false;
+    v.assign(m_data + m_pos, n);
+    m_pos += n;
+    return true;
+  }
+  template <typename T> bool get(list<T> &v) {
+    uint32_t n = 0;
+    if (!get(n))
+      return false;
+    v.clear();
+    for (uint32_t i = 0; i < n; ++i) {
+      T e{};
+      if (!get(e))
+        return false;
+      v.push_back(std::move(e));
+    }
+    return true;
+  }
+  template <typename T, size_t N> bool get(small_vector<T, N> &v) {
+    uint32_t n = 0;
+    if (!get(n))
+      return false;
+    v.clear();
+    v.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) {
+      T e{};
+      if (!get(e))
+        return false;
+      v.push_back(std::move(e));
+    }
+    return true;
+  }
+  bool get_member(var_type_t type, void *var);
+
+private:
+  const char *m_data;
+  size_t m_len;
+  size_t m_pos;
+};
+
+void snap_writer::put_member(var_type_t type, void *var) {
+  switch (type) {
+    case enum_type_string: put(*static_cast<string *>(var)); break;
+    case enum_type_bool: put((uint8_t)*static_cast<bool *>(var)); break;
+    case enum_type_int: put(*static_cast<int *>(var)); break;
+    case enum_type_long: put(*static_cast<long *>(var)); break;
+    case enum_type_unsigned: put(*static_cast<unsigned *>(var)); break;
+    case enum_type_double: put(*static_cast<double *>(var)); break;
+    case enum_type_list_int: put(*static_cast<list<int> *>(var)); break;
+    case enum_type_list_string: put(*static_cast<list<string> *>(var)); break;
+    case enum_type_istring: put(static_cast<istring *>(var)->str()); break;
+    case enum_type_channel_set: put(static_cast<channel_set *>(var)->mask()); break;
+    case enum_type_string_vector: put(*static_cast<string_vector *>(var)); break;
+    default: break;
+  }
+}
+
+bool snap_reader::get_member(var_type_t type, void *var) {
+  switch (type) {
+    case enum_type_string: return get(*static_cast<string *>(var));
+    case enum_type_bool: {
+      uint8_t b = 0;
+      if (!get(b))
+        return false;
+      *static_cast<bool *>(var) = (b != 0);
+      return true;
+    }
+    case enum_type_int: return get(*static_cast<int *>(var));
+    case enum_type_long: return get(*static_cast<long *>(var));
+    case enum_type_unsigned: return get(*static_cast<unsigned *>(var));
+    case enum_type_double: return get(*static_cast<double *>(var));
+    case enum_type_list_int: return get(*static_cast<list<int> *>(var));
+    case enum_type_list_string: return get(*static_cast<list<string> *>(var));
+    case enum_type_istring: {
+      string v;
+      if (!get(v))
+        return false;
+      *static_cast<istring *>(var) = v;
+      return true;
+    }
+    case enum_type_channel_set: {
+      uint32_t mask = 0;
+      if (!get(mask))
+        return false;
+      *static_cast<channel_set *>(var) = channel_set::from_mask(mask);
+      return true;
+    }
+    case enum_type_string_vector: return get(*static_cast<string_vector *>(var));
+    default: return true;
+  }
+}
+
+bool shim::save_snapshot(const string &fn, uint64_t source_hash, int ver) {
+  snap_writer w;
+  w.buffer().append(s_snap_magic, sizeof(s_snap_magic));
+  w.put(s_snap_format);
+  w.put(source_hash);
+  w.put(snap_schema_hash());
+  w.put((int32_t)ver);
+
+  // live objects in insertion order, store and order are rebuilt by inserting
+  // again, ids are allocated again in that order
+  w.put((uint32_t)m_store.size());
+  for (const auto &oc : ordered_view()) {
+    int tag = snap_tag(oc);
+    if (tag < 0)
+      return false;
+    w.put((uint8_t)tag);
+    w.put((int32_t)oc->get_ver());
+    oc->materialize_all();
+    for (const auto &m : oc->get_meta_info())
+      w.put_member(m.second.m_vtype, oc->get_member(m.second).m_var);
+  }
+  w.put(util_hash_fnv1a(w.buffer().data(), w.buffer().size()));
+
+  // write aside and rename, readers never see a partial snapshot
+  string tmp = fn + ".tmp";
+  FILE *fp = fopen(tmp.c_str(), "wb");
+  if (!fp)
+    return false;
+  bool ok = (fwrite(w.buffer().data(), 1, w.buffer().size(), fp) == w.buffer().size());
+  ok = (fclose(fp) == 0) && ok;
+  if (!ok || rename(tmp.c_str(), fn.c_str()) != 0) {
+    remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool shim::load_snapshot(const string &fn, uint64_t source_hash, int &ver) {
+  shared_ptr<cfg_mapping> m = cfg_mapping::open(fn);
+  if (!m || m->size() < sizeof(s_snap_magic) + sizeof(uint64_t))
+    return false;
+
+  size_t len = m->size() - sizeof(uint64_t);
+  uint64_t sum = 0;
+  memcpy(&sum, m->data() + len, sizeof(sum));
+  if (memcmp(m->data(), s_snap_magic, sizeof(s_snap_magic)) != 0
+      || sum != util_hash_fnv1a(m->data(), len))
+    return false;
+
+  snap_reader r(m->data() + sizeof(s_snap_magic), len - sizeof(s_snap_magic));
+  uint32_t format = 0;
+  uint64_t src = 0, schema = 0;
+  int32_t cfg_ver = 0;
+  if (!r.get(format) || format != s_snap_format || !r.get(src)
+      || src != source_hash || !r.get(schema) || schema != snap_schema_hash()
+      || !r.get(cfg_ver))
+    return false;
+
+  // decode all objects before the store is touched
+  uint32_t n = 0;
+  if (!r.get(n))
+    return false;
+  vector<object_config_ptr> objs;
+  objs.reserve(n);
+  bool deferred = object_config::is_id_deferred();
+  object_config::is_id_deferred() = true;
+  bool ok = true;
+  for (uint32_t i = 0; i < n && ok; ++i) {
+    uint8_t tag = 0;
+    int32_t obj_ver = 0;
+    object_config_ptr oc;
+    ok = r.get(tag) && r.get(obj_ver) && (oc = snap_create(tag)) != nullptr;
+    if (!ok)
+      break;
+    oc->set_ver(obj_ver);
+    meta_map &mm = oc->get_meta_info();
+    for (auto v = mm.begin(); v != mm.end() && ok; ++v)
+      ok = r.get_member(v->second.m_vtype, oc->get_member(v->second).m_var);
+    objs.push_back(oc);
+  }
+  object_config::is_id_deferred() = deferred;
+
+  if (!ok)
+    return false;
+
+  for (const auto &oc : objs) {
+    oc->assign_id();
+    insert_config(oc);
+  }
+  ver = cfg_ver;
+  return true;
+}
+
+} // namespace project
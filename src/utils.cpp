@@ -73,4 +73,17 @@ bool util_is_file_existing(const string &fpath)
     return (stat(fpath.c_str(), &st) == 0);
 }
 
+// 64-bit FNV-1a, pass the previous hash as seed to continue hashing
+uint64_t util_hash_fnv1a(const void *data, size_t len, uint64_t seed)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < len; ++i)
+    {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
 } // namespace project
@@ -1,6 +1,7 @@
 #ifndef __UTILS_H__
 #define __UTILS_H__
 
+#include <cstdint>
 #include <ctime>
 #include <sstream>
 #include <string>
@@ -20,6 +21,7 @@ size_t util_trim_leading_char(string &, const char);
 size_t util_trim_tailing_char(string &, const char);
 string util_extract_path(const string &);
 bool util_is_file_existing(const string &);
+uint64_t util_hash_fnv1a(const void *, size_t, uint64_t = 0xcbf29ce484222325ull);
 
 template<typename T>
     string util_val_to_str(const T &var, const T &invalid_val, const string &invalid_str)